@@ -352,8 +352,10 @@ ClangTidyASTConsumerFactory::CreateASTConsumer(
   CheckFactories->createChecks(&Context, Checks);
 
   ast_matchers::MatchFinder::MatchFinderOptions FinderOptions;
-  if (auto *P = Context.getCheckProfileData())
+  if (auto *P = Context.getCheckProfileData()) {
     FinderOptions.CheckProfiling.emplace(P->Records);
+    FinderOptions.CheckProfiling->MatcherRecords = &P->MatcherRecords;
+  }
 
   std::unique_ptr<ast_matchers::MatchFinder> Finder(
       new ast_matchers::MatchFinder(std::move(FinderOptions)));
@@ -89,7 +89,11 @@ struct ClangTidyStats {
 
 /// \brief Container for clang-tidy profiling data.
 struct ProfileData {
+  /// \brief Time spent in each check.
   llvm::StringMap<llvm::TimeRecord> Records;
+  /// \brief Time spent in each matcher, keyed by
+  /// "<check name>/<node kind>#<index>".
+  llvm::StringMap<llvm::TimeRecord> MatcherRecords;
 };
 
 /// \brief Every \c ClangTidyCheck reports errors through a \c DiagnosticsEngine
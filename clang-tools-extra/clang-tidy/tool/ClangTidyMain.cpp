@@ -17,6 +17,7 @@
 
 #include "../ClangTidy.h"
 #include "clang/Tooling/CommonOptionsParser.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Process.h"
 
 using namespace clang::ast_matchers;
@@ -175,12 +176,21 @@ configuration of all checks.
                                 cl::init(false), cl::cat(ClangTidyCategory));
 
 static cl::opt<bool> EnableCheckProfile("enable-check-profile", cl::desc(R"(
-Enable per-check timing profiles, and print a
-report to stderr.
+Enable per-check and per-matcher timing profiles,
+and print a report to stderr.
 )"),
                                         cl::init(false),
                                         cl::cat(ClangTidyCategory));
 
+static cl::opt<std::string> StoreCheckProfile("store-check-profile",
+                                              cl::desc(R"(
+JSON file to store per-check and per-matcher
+timing profiles in. The entries are sorted by
+decreasing wall time.
+)"),
+                                              cl::value_desc("filename"),
+                                              cl::cat(ClangTidyCategory));
+
 static cl::opt<bool> AnalyzeTemporaryDtors("analyze-temporary-dtors",
                                            cl::desc(R"(
 Enable temporary destructor-aware analysis in
@@ -239,18 +249,22 @@ static void printStats(const ClangTidyStats &Stats) {
   }
 }
 
-static void printProfileData(const ProfileData &Profile,
-                             llvm::raw_ostream &OS) {
+/// \brief Returns the entries of \p Records sorted by decreasing wall time.
+static std::vector<std::pair<llvm::TimeRecord, StringRef>>
+sortProfileRecords(const llvm::StringMap<llvm::TimeRecord> &Records) {
   // Time is first to allow for sorting by it.
   std::vector<std::pair<llvm::TimeRecord, StringRef>> Timers;
-  TimeRecord Total;
-
-  for (const auto &P : Profile.Records) {
+  for (const auto &P : Records)
     Timers.emplace_back(P.getValue(), P.getKey());
-    Total += P.getValue();
-  }
+  std::sort(Timers.rbegin(), Timers.rend());
+  return Timers;
+}
 
-  std::sort(Timers.begin(), Timers.end());
+static void printProfileTable(const llvm::StringMap<llvm::TimeRecord> &Records,
+                              StringRef NameHeader, llvm::raw_ostream &OS) {
+  TimeRecord Total;
+  for (const auto &P : Records)
+    Total += P.getValue();
 
   std::string Line = "===" + std::string(73, '-') + "===\n";
   OS << Line;
@@ -264,20 +278,55 @@ static void printProfileData(const ProfileData &Profile,
   OS << "   ---Wall Time---";
   if (Total.getMemUsed())
     OS << "  ---Mem---";
-  OS << "  --- Name ---\n";
+  OS << "  --- " << NameHeader << " ---\n";
 
   // Loop through all of the timing data, printing it out.
-  for (auto I = Timers.rbegin(), E = Timers.rend(); I != E; ++I) {
-    I->first.print(Total, OS);
-    OS << I->second << '\n';
+  for (const auto &Timer : sortProfileRecords(Records)) {
+    Timer.first.print(Total, OS);
+    OS << Timer.second << '\n';
   }
 
   Total.print(Total, OS);
   OS << "Total\n";
   OS << Line << "\n";
+}
+
+static void printProfileData(const ProfileData &Profile,
+                             llvm::raw_ostream &OS) {
+  printProfileTable(Profile.Records, "Name", OS);
+  if (!Profile.MatcherRecords.empty())
+    printProfileTable(Profile.MatcherRecords, "Matcher", OS);
   OS.flush();
 }
 
+static void
+exportProfileRecords(const llvm::StringMap<llvm::TimeRecord> &Records,
+                     llvm::raw_ostream &OS) {
+  OS << "[";
+  StringRef Separator = "\n";
+  for (const auto &Timer : sortProfileRecords(Records)) {
+    OS << Separator << "    {\"name\": \"";
+    OS.write_escaped(Timer.second);
+    OS << "\", \"wall\": " << format("%.6f", Timer.first.getWallTime())
+       << ", \"user\": " << format("%.6f", Timer.first.getUserTime())
+       << ", \"sys\": " << format("%.6f", Timer.first.getSystemTime())
+       << "}";
+    Separator = ",\n";
+  }
+  OS << "\n  ]";
+}
+
+/// \brief Writes \p Profile as a JSON object with a "checks" and a "matchers"
+/// array, each sorted by decreasing wall time.
+static void exportProfileData(const ProfileData &Profile,
+                              llvm::raw_ostream &OS) {
+  OS << "{\n  \"checks\": ";
+  exportProfileRecords(Profile.Records, OS);
+  OS << ",\n  \"matchers\": ";
+  exportProfileRecords(Profile.MatcherRecords, OS);
+  OS << "\n}\n";
+}
+
 static std::unique_ptr<ClangTidyOptionsProvider> createOptionsProvider() {
   ClangTidyGlobalOptions GlobalOptions;
   if (std::error_code Err = parseLineFilter(LineFilter, GlobalOptions)) {
@@ -404,8 +453,9 @@ static int clangTidyMain(int argc, const char **argv) {
   ProfileData Profile;
 
   ClangTidyContext Context(std::move(OwningOptionsProvider));
+  const bool EnableProfiling = EnableCheckProfile || !StoreCheckProfile.empty();
   runClangTidy(Context, OptionsParser.getCompilations(), PathList,
-               EnableCheckProfile ? &Profile : nullptr);
+               EnableProfiling ? &Profile : nullptr);
   ArrayRef<ClangTidyError> Errors = Context.getErrors();
   bool FoundErrors =
       std::find_if(Errors.begin(), Errors.end(), [](const ClangTidyError &E) {
@@ -440,6 +490,16 @@ static int clangTidyMain(int argc, const char **argv) {
   if (EnableCheckProfile)
     printProfileData(Profile, llvm::errs());
 
+  if (!StoreCheckProfile.empty()) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(StoreCheckProfile, EC, llvm::sys::fs::F_Text);
+    if (EC) {
+      llvm::errs() << "Error opening output file: " << EC.message() << '\n';
+      return 1;
+    }
+    exportProfileData(Profile, OS);
+  }
+
   if (WErrorCount) {
     if (!Quiet) {
       StringRef Plural = WErrorCount == 1 ? "" : "s";
@@ -0,0 +1,22 @@
+// RUN: clang-tidy -enable-check-profile -checks='-*,readability-function-size' %s -- 2>&1 | FileCheck --check-prefix=CHECK-REPORT %s
+// RUN: clang-tidy -store-check-profile=%t.json -checks='-*,readability-function-size' %s --
+// RUN: FileCheck --check-prefix=CHECK-JSON %s < %t.json
+
+// CHECK-REPORT: ===-------------------------------------------------------------------------===
+// CHECK-REPORT: {{.*}}  --- Name ---
+// CHECK-REPORT: {{.*}}readability-function-size
+// CHECK-REPORT: {{.*}}Total
+// CHECK-REPORT: {{.*}}  --- Matcher ---
+// CHECK-REPORT: {{.*}}readability-function-size/FunctionDecl#0
+// CHECK-REPORT: {{.*}}Total
+
+// CHECK-JSON: {
+// CHECK-JSON-NEXT:   "checks": [
+// CHECK-JSON-NEXT:     {"name": "readability-function-size", "wall": {{[0-9.]+}}, "user": {{[0-9.]+}}, "sys": {{[0-9.]+}}}
+// CHECK-JSON-NEXT:   ],
+// CHECK-JSON-NEXT:   "matchers": [
+// CHECK-JSON-NEXT:     {"name": "readability-function-size/FunctionDecl#0", "wall": {{[0-9.]+}}, "user": {{[0-9.]+}}, "sys": {{[0-9.]+}}}
+// CHECK-JSON-NEXT:   ]
+// CHECK-JSON-NEXT: }
+
+void f() {}
@@ -781,8 +781,23 @@ protected:
   void addSpecializationImpl(llvm::FoldingSetVector<EntryType> &Specs,
                              EntryType *Entry, void *InsertPos);
 
+  /// \brief A specialization that is known only by its external declaration
+  /// ID.
+  struct LazySpecializationInfo {
+    /// \brief The ID of the specialization.
+    uint32_t DeclID;
+
+    /// \brief A hash of the template arguments of the specialization, which
+    /// is equal for equivalent argument lists from any AST file.
+    unsigned ArgsHash;
+
+    /// \brief Whether this is a partial specialization.
+    bool IsPartial;
+  };
+
   struct CommonBase {
-    CommonBase() : InstantiatedFromMember(nullptr, false) { }
+    CommonBase()
+        : InstantiatedFromMember(nullptr, false), LazySpecializations() {}
 
     /// \brief The template from which this was most
     /// directly instantiated (or null).
@@ -791,8 +806,33 @@ protected:
     /// was explicitly specialized.
     llvm::PointerIntPair<RedeclarableTemplateDecl*, 1, bool>
       InstantiatedFromMember;
+
+    /// \brief If non-null, points to an array of specializations (including
+    /// partial specializations) known only by their external declaration IDs.
+    ///
+    /// The DeclID of the first element is the number of specializations/
+    /// partial specializations that follow. They are sorted by ArgsHash, and
+    /// are removed from the array once they are loaded.
+    LazySpecializationInfo *LazySpecializations;
   };
 
+  /// \brief Load the lazily-loaded specializations from the external source,
+  /// or only the partial specializations if \p OnlyPartial is true.
+  void loadLazySpecializationsImpl(bool OnlyPartial = false) const;
+
+  /// \brief Load the lazily-loaded specializations whose template arguments
+  /// may be \p Args, so that a lookup of \p Args does not need to
+  /// deserialize all the specializations of this template.
+  void loadLazySpecializationsImpl(ArrayRef<TemplateArgument> Args) const;
+
+  /// \brief Compute the hash of the template arguments of a specialization
+  /// that is stored with its lazy declaration ID.
+  unsigned computeSpecializationHash(ArrayRef<TemplateArgument> Args) const;
+
+  /// \brief Compute the hash of the template arguments of the specialization
+  /// \p D of this template.
+  unsigned computeSpecializationHash(const Decl *D) const;
+
   /// \brief Pointer to the common data shared by all declarations of this
   /// template.
   mutable CommonBase *Common;
@@ -920,6 +960,7 @@ public:
   friend class ASTReader;
   friend class ASTDeclReader;
   friend class ASTDeclWriter;
+  friend class ASTWriter;
 };
 
 template <> struct RedeclarableTemplateDecl::
@@ -941,7 +982,7 @@ protected:
   /// \brief Data that is common to all of the declarations of a given
   /// function template.
   struct Common : CommonBase {
-    Common() : InjectedArgs(), LazySpecializations() { }
+    Common() : InjectedArgs() { }
 
     /// \brief The function template specializations for this function
     /// template, including explicit specializations and instantiations.
@@ -955,13 +996,6 @@ protected:
     /// template, and is allocated lazily, since most function templates do not
     /// require the use of this information.
     TemplateArgument *InjectedArgs;
-
-    /// \brief If non-null, points to an array of specializations known only
-    /// by their external declaration IDs.
-    ///
-    /// The first value in the array is the number of of specializations
-    /// that follow.
-    uint32_t *LazySpecializations;
   };
 
   FunctionTemplateDecl(ASTContext &C, DeclContext *DC, SourceLocation L,
@@ -2038,7 +2072,7 @@ protected:
   /// \brief Data that is common to all of the declarations of a given
   /// class template.
   struct Common : CommonBase {
-    Common() : LazySpecializations() { }
+    Common() { }
 
     /// \brief The class template specializations for this class
     /// template, including explicit specializations and instantiations.
@@ -2051,13 +2085,6 @@ protected:
 
     /// \brief The injected-class-name type for this class template.
     QualType InjectedClassNameType;
-
-    /// \brief If non-null, points to an array of specializations (including
-    /// partial specializations) known only by their external declaration IDs.
-    ///
-    /// The first value in the array is the number of of specializations/
-    /// partial specializations that follow.
-    uint32_t *LazySpecializations;
   };
 
   /// \brief Retrieve the set of specializations of this class template.
@@ -2855,7 +2882,7 @@ protected:
   /// \brief Data that is common to all of the declarations of a given
   /// variable template.
   struct Common : CommonBase {
-    Common() : LazySpecializations() {}
+    Common() {}
 
     /// \brief The variable template specializations for this variable
     /// template, including explicit specializations and instantiations.
@@ -2865,13 +2892,6 @@ protected:
     /// template.
     llvm::FoldingSetVector<VarTemplatePartialSpecializationDecl>
     PartialSpecializations;
-
-    /// \brief If non-null, points to an array of specializations (including
-    /// partial specializations) known ownly by their external declaration IDs.
-    ///
-    /// The first value in the array is the number of of specializations/
-    /// partial specializations that follow.
-    uint32_t *LazySpecializations;
   };
 
   /// \brief Retrieve the set of specializations of this variable template.
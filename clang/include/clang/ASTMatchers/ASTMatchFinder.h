@@ -42,6 +42,7 @@
 #define LLVM_CLANG_ASTMATCHERS_ASTMATCHFINDER_H
 
 #include "clang/ASTMatchers/ASTMatchers.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Timer.h"
@@ -127,6 +128,15 @@ public:
 
       /// \brief Per bucket timing information.
       llvm::StringMap<llvm::TimeRecord> &Records;
+
+      /// \brief Optional per matcher timing information.
+      ///
+      /// If set, the time spent in each top-level matcher is additionally
+      /// recorded here under the key "<bucket>/<node kind>#<N>", where \c N
+      /// is the position of the matcher among the matchers registered by the
+      /// same callback for that node kind. Time spent in the
+      /// start/end of translation unit hooks is only recorded in \c Records.
+      llvm::StringMap<llvm::TimeRecord> *MatcherRecords = nullptr;
     };
 
     /// \brief Enables per-check timers.
@@ -215,9 +225,23 @@ public:
     llvm::SmallPtrSet<MatchCallback *, 16> AllCallbacks;
   };
 
+  /// \brief For each node kind, the indices into \c MatchersByType::DeclOrStmt
+  /// of the matchers that can match a node of exactly that kind.
+  typedef llvm::DenseMap<ast_type_traits::ASTNodeKind,
+                         std::vector<unsigned short>>
+      MatcherFiltersByKind;
+
 private:
   MatchersByType Matchers;
 
+  /// \brief Dispatch table of the \c Decl and \c Stmt matchers.
+  ///
+  /// Filled lazily while matching and shared by every traversal started from
+  /// this finder, so that the kind checks are only done once per node kind
+  /// instead of once per node kind and translation unit (or call to
+  /// \c match()). Cleared when a matcher is added.
+  MatcherFiltersByKind MatcherFilters;
+
   MatchFinderOptions Options;
 
   /// \brief Called when parsing is done.
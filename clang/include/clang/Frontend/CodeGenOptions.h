@@ -187,6 +187,11 @@ public:
   /// the summary and module symbol table (and not, e.g. any debug metadata).
   std::string ThinLinkBitcodeFile;
 
+  /// The files to which the object code of the additional partitions of the
+  /// module is written when generating code in parallel. The first partition
+  /// is written to the main output file.
+  std::vector<std::string> ParallelCodeGenOutputs;
+
   /// A list of file names passed with -fcuda-include-gpubinary options to
   /// forward to CUDA runtime back-end for incorporating them into host-side
   /// object file.
@@ -0,0 +1,52 @@
+//===- DependencyDirectivesSourceMinimizer.h - Minimize source -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines a function that minimizes a source file down to the
+/// preprocessor directives that can affect its dependencies.
+///
+/// Preprocessing the minimized source produces the same set of included files
+/// as preprocessing the original one, as long as nothing depends on the
+/// tokens that were dropped (e.g. __LINE__ or __COUNTER__ in an #include).
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_DEPENDENCYDIRECTIVESSOURCEMINIMIZER_H
+#define LLVM_CLANG_LEX_DEPENDENCYDIRECTIVESSOURCEMINIMIZER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace clang {
+
+/// \brief Minimize \p Input down to the preprocessor directives that might
+/// have an effect on the dependencies of a translation unit.
+///
+/// The directives that are kept are the include-like ones (#include,
+/// #include_next, #import, #__include_macros and \@import), the ones defining
+/// macros (#define, #undef), the conditional ones (#if, #ifdef, #ifndef,
+/// #elif, #else, #endif) and the pragmas that affect header search or macro
+/// definitions (once, system_header, push_macro, pop_macro, include_alias).
+/// Comments are removed, escaped newlines are joined and every directive is
+/// written on a line of its own.
+///
+/// \param Input The source to minimize.
+/// \param Output Receives the minimized source.
+///
+/// \returns true if \p Input could not be minimized reliably, e.g. because
+/// of an unterminated block comment or raw string literal; the contents of
+/// \p Output are unspecified in that case and the original source should be
+/// used instead.
+bool minimizeSourceToDependencyDirectives(StringRef Input,
+                                          SmallVectorImpl<char> &Output);
+
+} // end namespace clang
+
+#endif // LLVM_CLANG_LEX_DEPENDENCYDIRECTIVESSOURCEMINIMIZER_H
@@ -0,0 +1,119 @@
+//===--- HeaderLookupCache.h - Persistent header lookup cache ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the HeaderLookupCache interface.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_HEADERLOOKUPCACHE_H
+#define LLVM_CLANG_LEX_HEADERLOOKUPCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/StringSaver.h"
+#include <memory>
+#include <string>
+
+namespace llvm {
+class MemoryBuffer;
+template <typename Info> class OnDiskIterableChainedHashTable;
+}
+
+namespace clang {
+
+class DirectoryEntry;
+class FileManager;
+class HeaderLookupCacheTrait;
+
+/// \brief A cache of the contents of the directories searched for headers,
+/// persisted on disk and shared by the compilations that use the same cache
+/// file.
+///
+/// Looking up a header in a deep include path stats a candidate file in
+/// every directory, and most of these lookups fail. With the listings of the
+/// searched directories at hand, the failing lookups need no stat at all;
+/// a listing is validated by a single stat of its directory per compilation,
+/// comparing its modification time with the one that was recorded.
+///
+/// Directories are keyed by their absolute real path, so that compilations
+/// from different working directories never share the listing of a
+/// directory they spell the same way.
+///
+/// Names are compared case-insensitively, so that the cache never rejects a
+/// file a case-insensitive file system would find. The cache only ever
+/// answers "the file does not exist"; whenever it is unsure it lets header
+/// search stat the file as usual.
+class HeaderLookupCache {
+public:
+  /// \brief Creates a cache backed by the file \p Path, loading the listings
+  /// it already holds if it exists and is valid. Relative directories are
+  /// resolved against the working directory of \p FileMgr.
+  HeaderLookupCache(StringRef Path, FileManager &FileMgr);
+  ~HeaderLookupCache();
+
+  /// \brief Returns false if the file \p Filename, relative to the
+  /// directory \p Dir, definitely does not exist.
+  bool mayContainFile(const DirectoryEntry *Dir, StringRef Filename);
+
+  /// \brief Writes the cache back to disk if directories had to be listed
+  /// during this compilation.
+  ///
+  /// The cache file is replaced atomically, so concurrent compilations may
+  /// share it; failures are silently ignored since the cache is only an
+  /// optimization.
+  void write();
+
+  void PrintStats() const;
+
+private:
+  struct DirectoryListing {
+    /// \brief Whether the directory could be listed.
+    bool Known = false;
+    /// \brief Whether the listing was read from the file system during this
+    /// compilation and should be persisted.
+    bool IsNew = false;
+    /// \brief The modification time of the directory.
+    uint64_t ModTime = 0;
+    /// \brief The lowercased names of the entries of the directory.
+    llvm::DenseSet<StringRef> Names;
+  };
+
+  typedef llvm::OnDiskIterableChainedHashTable<HeaderLookupCacheTrait>
+      OnDiskTable;
+
+  StringRef getCanonicalDir(const DirectoryEntry *Dir);
+  const DirectoryListing &getListing(StringRef Dir);
+
+  std::string Path;
+  FileManager &FileMgr;
+  /// \brief The time at which the loaded cache file was written.
+  uint64_t WriteTime = 0;
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<OnDiskTable> Table;
+
+  /// \brief The absolute real paths of the searched directories, or an empty
+  /// string for those that could not be resolved.
+  llvm::DenseMap<const DirectoryEntry *, StringRef> CanonicalDirs;
+  llvm::StringMap<DirectoryListing> Listings;
+  llvm::BumpPtrAllocator Alloc;
+  llvm::StringSaver Saver;
+
+  unsigned NumLookups = 0;
+  unsigned NumRejectedLookups = 0;
+  unsigned NumListingsRead = 0;
+  unsigned NumListingsReused = 0;
+};
+
+} // end namespace clang
+
+#endif // LLVM_CLANG_LEX_HEADERLOOKUPCACHE_H
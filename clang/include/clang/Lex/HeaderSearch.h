@@ -30,6 +30,7 @@ class DiagnosticsEngine;
 class ExternalPreprocessorSource;
 class FileEntry;
 class FileManager;
+class HeaderLookupCache;
 class HeaderSearchOptions;
 class IdentifierInfo;
 class Preprocessor;
@@ -235,6 +236,10 @@ class HeaderSearch {
 
   /// \brief Entity used to look up stored header file information.
   ExternalHeaderFileInfoSource *ExternalSource;
+
+  /// \brief The persistent cache of the directories searched for headers,
+  /// used to skip the lookups that cannot succeed.
+  std::unique_ptr<HeaderLookupCache> LookupCache;
   
   // Various statistics we track for performance analysis.
   unsigned NumIncluded;
@@ -343,6 +348,12 @@ public:
   void SetExternalSource(ExternalHeaderFileInfoSource *ES) {
     ExternalSource = ES;
   }
+
+  /// \brief Set the persistent cache of the directories searched for
+  /// headers.
+  void setLookupCache(std::unique_ptr<HeaderLookupCache> Cache);
+
+  HeaderLookupCache *getLookupCache() const { return LookupCache.get(); }
   
   /// \brief Set the target information for the header search, if not
   /// already known.
@@ -150,6 +150,10 @@ public:
   /// \brief The set of user-provided virtual filesystem overlay files.
   std::vector<std::string> VFSOverlayFiles;
 
+  /// \brief The file caching the contents of the directories searched for
+  /// headers across compilations, if any.
+  std::string LookupCachePath;
+
   /// Include the compiler builtin includes.
   unsigned UseBuiltinIncludes : 1;
 
@@ -173,6 +177,14 @@ public:
   /// \brief Whether to validate system input files when a module is loaded.
   unsigned ModulesValidateSystemHeaders : 1;
 
+  /// \brief If true, the input files of implicitly-built modules are not
+  /// verified when the module is loaded, but only when the source locations
+  /// of one of them are first needed, e.g. to deserialize a declaration.
+  ///
+  /// A module found to be out of date this way can no longer be rebuilt in
+  /// the current compilation, so this is an error instead.
+  unsigned ModulesLazyValidateInputFiles : 1;
+
   /// Whether the module includes debug information (-gmodules).
   unsigned UseDebugInfo : 1;
 
@@ -188,7 +200,8 @@ public:
         UseBuiltinIncludes(true), UseStandardSystemIncludes(true),
         UseStandardCXXIncludes(true), UseLibcxx(false), Verbose(false),
         ModulesValidateOncePerBuildSession(false),
-        ModulesValidateSystemHeaders(false), UseDebugInfo(false),
+        ModulesValidateSystemHeaders(false),
+        ModulesLazyValidateInputFiles(false), UseDebugInfo(false),
         ModulesValidateDiagnosticOptions(true), ModulesHashContent(false) {}
 
   /// AddPath - Add the \p Path path to the specified \p Group list.
@@ -207,6 +207,15 @@ public:
   /// uninterpreted string.  This switches the lexer out of directive mode.
   void ReadToEndOfLine(SmallVectorImpl<char> *Result = nullptr);
 
+  /// \brief Skip the rest of the current line in raw mode if it contains
+  /// nothing that can affect how the following lines are lexed.
+  ///
+  /// Used to skip excluded conditional blocks without forming a token for
+  /// everything in them. Lines that contain comments, string literals,
+  /// escaped newlines, trigraphs or the code completion point are left
+  /// untouched.
+  void skipExcludedLineRemainder();
+
 
   /// Diag - Forwarding function for diagnostics.  This translate a source
   /// position in the current buffer into a SourceLocation object for rendering.
@@ -34,6 +34,7 @@ namespace clang {
 class DirectoryEntry;
 class FileEntry;
 class FileManager;
+class GlobalModuleIndexBuilder;
 class IdentifierIterator;
 class PCHContainerOperations;
 class PCHContainerReader;
@@ -123,6 +124,14 @@ class GlobalModuleIndex {
   GlobalModuleIndex(const GlobalModuleIndex &) = delete;
   GlobalModuleIndex &operator=(const GlobalModuleIndex &) = delete;
 
+  /// \brief Add to \p Builder the module files that did not change since
+  /// this index was built, and the identifiers they provide.
+  ///
+  /// \param UnchangedFiles Will be populated with the module files added.
+  void addUnchangedModules(
+      FileManager &FileMgr, GlobalModuleIndexBuilder &Builder,
+      llvm::SmallPtrSetImpl<const FileEntry *> &UnchangedFiles) const;
+
 public:
   ~GlobalModuleIndex();
 
@@ -269,6 +269,9 @@ private:
   /// \sa getMaxNodesPerTopLevelFunction
   Optional<unsigned> MaxNodesPerTopLevelFunction;
 
+  /// \sa getMaxGraphMemory
+  Optional<unsigned> MaxGraphMemory;
+
   /// \sa shouldInlineLambdas
   Optional<bool> InlineLambdas;
 
@@ -278,6 +281,12 @@ private:
   /// \sa shouldDisplayNotesAsEvents
   Optional<bool> DisplayNotesAsEvents;
 
+  /// \sa getAnalysisShardCount
+  Optional<unsigned> AnalysisShardCount;
+
+  /// \sa getAnalysisShardIndex
+  Optional<unsigned> AnalysisShardIndex;
+
   /// A helper function that retrieves option for a given full-qualified
   /// checker name.
   /// Options for checkers can be specified via 'analyzer-config' command-line
@@ -552,6 +561,14 @@ public:
   /// This is controlled by the 'max-nodes' config option.
   unsigned getMaxNodesPerTopLevelFunction();
 
+  /// Returns the maximum amount of memory, in megabytes, the analyzer can
+  /// allocate for the nodes and states of a top level function. Past half of
+  /// this budget nodes are reclaimed more aggressively, and the analysis of
+  /// the function stops once it is exhausted. 0 means no limit, the default.
+  ///
+  /// This is controlled by the 'max-graph-memory' config option.
+  unsigned getMaxGraphMemory();
+
   /// Returns true if lambdas should be inlined. Otherwise a sink node will be
   /// generated each time a LambdaExpr is visited.
   bool shouldInlineLambdas();
@@ -568,6 +585,25 @@ public:
   /// to false when unset.
   bool shouldDisplayNotesAsEvents();
 
+  /// Returns the number of shards the path-sensitive analysis of the
+  /// translation unit is split into. Functions that call one another are
+  /// assigned to the same shard, so that running one analyzer process per
+  /// shard analyzes the translation unit on several cores and reports what a
+  /// single process would.
+  ///
+  /// This is controlled by the 'shard-count' config option, which defaults
+  /// to 1.
+  unsigned getAnalysisShardCount();
+
+  /// Returns the shard analyzed by this process, which must be in
+  /// [0, shard-count). Syntactic checks only run in shard 0, while the
+  /// end-of-translation-unit checks run in every shard, on what that shard
+  /// analyzed.
+  ///
+  /// This is controlled by the 'shard-index' config option, which defaults
+  /// to 0.
+  unsigned getAnalysisShardIndex();
+
 public:
   AnalyzerOptions() :
     AnalysisStoreOpt(RegionStoreModel),
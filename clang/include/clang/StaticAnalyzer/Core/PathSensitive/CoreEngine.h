@@ -84,6 +84,10 @@ private:
   /// (This data is owned by AnalysisConsumer.)
   FunctionSummariesTy *FunctionSummaries;
 
+  /// The number of bytes the graph and the states may use, or 0 if there is
+  /// no limit.
+  uint64_t MemoryBudget;
+
   void generateNode(const ProgramPoint &Loc,
                     ProgramStateRef State,
                     ExplodedNode *Pred);
@@ -116,7 +120,13 @@ public:
   /// Construct a CoreEngine object to analyze the provided CFG.
   CoreEngine(SubEngine &subengine, FunctionSummariesTy *FS)
       : SubEng(subengine), WList(WorkList::makeDFS()),
-        BCounterFactory(G.getAllocator()), FunctionSummaries(FS) {}
+        BCounterFactory(G.getAllocator()), FunctionSummaries(FS),
+        MemoryBudget(0) {}
+
+  /// Limit the memory the graph and the states may use. Past half of the
+  /// budget, nodes are reclaimed aggressively; once it is exhausted, the
+  /// worklist algorithm stops as if it had run out of steps.
+  void setMemoryBudget(uint64_t Bytes) { MemoryBudget = Bytes; }
 
   /// getGraph - Returns the exploded graph.
   ExplodedGraph &getGraph() { return G; }
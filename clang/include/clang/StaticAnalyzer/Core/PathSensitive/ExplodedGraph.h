@@ -284,6 +284,13 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
 
+  /// Whether to also reclaim the nodes only kept to produce more precise
+  /// diagnostics.
+  bool AggressiveReclamation;
+
+  /// The number of nodes reclaimed so far.
+  unsigned NumReclaimedNodes;
+
 public:
 
   /// \brief Retrieve the node associated with a (Location,State) pair,
@@ -390,6 +397,14 @@ public:
     ReclaimCounter = ReclaimNodeInterval = Interval;
   }
 
+  /// Also reclaim the nodes that are only kept to anchor path diagnostics
+  /// precisely, trading diagnostic quality for memory.
+  void enableAggressiveNodeReclamation() { AggressiveReclamation = true; }
+
+  bool isReclaimingNodes() const { return ReclaimNodeInterval != 0; }
+
+  unsigned getNumReclaimedNodes() const { return NumReclaimedNodes; }
+
   /// Reclaim "uninteresting" nodes created since the last time this method
   /// was called.
   void reclaimRecentlyAllocatedNodes();
@@ -517,6 +517,9 @@ public:
 
   llvm::BumpPtrAllocator& getAllocator() { return Alloc; }
 
+  /// Returns the number of distinct states currently interned.
+  unsigned getNumStates() const { return StateSet.size(); }
+
   MemRegionManager& getRegionManager() {
     return svalBuilder->getRegionManager();
   }
@@ -0,0 +1,178 @@
+//===- DependencyScanning.h - Fast dependency scanning ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the infrastructure used to compute the dependencies of
+//  many translation units quickly: the sources are minimized down to their
+//  preprocessor directives, and the minimized files as well as the results of
+//  the stat calls are cached and shared by all translation units.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLING_DEPENDENCYSCANNING_H
+#define LLVM_CLANG_TOOLING_DEPENDENCYSCANNING_H
+
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/ErrorOr.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class DiagnosticConsumer;
+
+namespace tooling {
+
+/// \brief The stat result and the (possibly minimized) contents of a file, as
+/// seen by the dependency scanner.
+///
+/// An entry is immutable once it has been added to the shared cache.
+class CachedFileSystemEntry {
+public:
+  /// \brief Reads the entry at \p Filename from \p FS, minimizing its
+  /// contents if \p Minimize is set and the file is a regular file.
+  static CachedFileSystemEntry create(StringRef Filename, vfs::FileSystem &FS,
+                                      bool Minimize);
+
+  /// \brief The status of the file or the error that occurred while reading
+  /// it. The size of a minimized file is the size of its minimized contents.
+  const llvm::ErrorOr<vfs::Status> &getStatus() const { return MaybeStat; }
+
+  /// \brief The contents of the file, empty for directories.
+  StringRef getContents() const { return Contents; }
+
+  /// \brief Whether the contents are the minimized ones.
+  bool isMinimized() const { return Minimized; }
+
+private:
+  CachedFileSystemEntry() : MaybeStat(std::error_code()), Minimized(false) {}
+
+  llvm::ErrorOr<vfs::Status> MaybeStat;
+  std::string Contents;
+  bool Minimized;
+};
+
+/// \brief A cache of \c CachedFileSystemEntry objects that is shared by all
+/// the workers of a dependency scan.
+///
+/// The cache is split into shards to reduce the contention between the
+/// workers, and assumes that the files do not change during the scan.
+class DependencyScanningFilesystemSharedCache {
+public:
+  DependencyScanningFilesystemSharedCache();
+
+  /// \brief Returns the cached entry for the absolute path \p Key, creating
+  /// it with \p Create if it is not in the cache yet.
+  ///
+  /// The entry is created outside of the lock so that reading and minimizing
+  /// a large file does not block the other workers; if two workers race to
+  /// create the same entry, the first one to finish wins.
+  template <typename CreateFn>
+  const CachedFileSystemEntry &getOrCreate(StringRef Key, CreateFn Create) {
+    CacheShard &Shard = getShard(Key);
+    {
+      std::lock_guard<std::mutex> Lock(Shard.Mutex);
+      auto It = Shard.Cache.find(Key);
+      if (It != Shard.Cache.end())
+        return It->second;
+    }
+    CachedFileSystemEntry Entry = Create();
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    return Shard.Cache.insert(std::make_pair(Key, std::move(Entry)))
+        .first->second;
+  }
+
+private:
+  struct CacheShard {
+    std::mutex Mutex;
+    llvm::StringMap<CachedFileSystemEntry, llvm::BumpPtrAllocator> Cache;
+  };
+
+  CacheShard &getShard(StringRef Key);
+
+  std::vector<CacheShard> Shards;
+};
+
+/// \brief A virtual file system that serves the files of the underlying file
+/// system minimized down to their preprocessor directives.
+///
+/// The entries are looked up in the shared cache first; each file system
+/// also keeps a private, lock-free map of the entries it has already seen.
+/// Module map files and precompiled files are served unmodified, and so are
+/// the files that could not be minimized reliably.
+///
+/// The working directory is tracked by the file system itself and the
+/// underlying file system is only given absolute paths, so that the workers
+/// never change the working directory of the process. A file system is meant
+/// to be used by a single worker thread at a time.
+class DependencyScanningFilesystem : public vfs::FileSystem {
+public:
+  DependencyScanningFilesystem(
+      DependencyScanningFilesystemSharedCache &SharedCache,
+      IntrusiveRefCntPtr<vfs::FileSystem> UnderlyingFS);
+
+  llvm::ErrorOr<vfs::Status> status(const Twine &Path) override;
+  llvm::ErrorOr<std::unique_ptr<vfs::File>>
+  openFileForRead(const Twine &Path) override;
+  vfs::directory_iterator dir_begin(const Twine &Dir,
+                                    std::error_code &EC) override;
+  llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override;
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
+
+private:
+  llvm::ErrorOr<const CachedFileSystemEntry *> getEntry(const Twine &Path);
+
+  DependencyScanningFilesystemSharedCache &SharedCache;
+  IntrusiveRefCntPtr<vfs::FileSystem> UnderlyingFS;
+  std::string WorkingDirectory;
+  /// \brief The entries this file system has already looked up, keyed by
+  /// absolute path.
+  llvm::StringMap<const CachedFileSystemEntry *, llvm::BumpPtrAllocator>
+      LocalCache;
+};
+
+/// \brief Computes the dependencies of translation units by running only the
+/// preprocessor over their minimized sources.
+///
+/// The dependency file is written as requested by the command line
+/// (-M, -MD, -MF, -MT, ...), so it is identical to the one produced by a
+/// regular compilation. Commands that do not ask for a dependency file are
+/// skipped. A worker may be reused for many commands but must only be used
+/// by one thread at a time; create one worker per thread and let them share
+/// a \c DependencyScanningFilesystemSharedCache.
+class DependencyScanningWorker {
+public:
+  DependencyScanningWorker(
+      DependencyScanningFilesystemSharedCache &SharedCache,
+      IntrusiveRefCntPtr<vfs::FileSystem> UnderlyingFS =
+          vfs::getRealFileSystem());
+
+  /// \brief Scans the dependencies of a single compilation.
+  ///
+  /// \param CommandLine The compiler command line, including the name of the
+  /// compiler in CommandLine[0].
+  /// \param WorkingDirectory The directory the command is run from.
+  /// \param DiagConsumer Receives the diagnostics of the scan; they are
+  /// printed to stderr if null.
+  ///
+  /// \returns true if the dependencies could be computed.
+  bool runOnCommand(const std::vector<std::string> &CommandLine,
+                    StringRef WorkingDirectory,
+                    DiagnosticConsumer *DiagConsumer = nullptr);
+
+private:
+  IntrusiveRefCntPtr<DependencyScanningFilesystem> DepFS;
+};
+
+} // end namespace tooling
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLING_DEPENDENCYSCANNING_H
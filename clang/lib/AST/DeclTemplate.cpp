@@ -20,7 +20,9 @@
 #include "clang/AST/TypeLoc.h"
 #include "clang/Basic/Builtins.h"
 #include "clang/Basic/IdentifierTable.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include <algorithm>
 #include <memory>
 using namespace clang;
 
@@ -165,6 +167,161 @@ RedeclarableTemplateDecl::CommonBase *RedeclarableTemplateDecl::getCommonPtr() c
   return Common;
 }
 
+void RedeclarableTemplateDecl::loadLazySpecializationsImpl(
+    bool OnlyPartial) const {
+  // Grab the most recent declaration to ensure we've loaded any lazy
+  // redeclarations of this template.
+  //
+  // FIXME: Avoid walking the entire redeclaration chain here.
+  CommonBase *CommonBasePtr = getMostRecentDecl()->getCommonPtr();
+  LazySpecializationInfo *Specs = CommonBasePtr->LazySpecializations;
+  if (!Specs)
+    return;
+
+  SmallVector<uint32_t, 8> IDs;
+  if (OnlyPartial) {
+    // Take the partial specializations out of the array before loading them,
+    // since loading may add more lazy specializations to this template.
+    LazySpecializationInfo *End = Specs + 1 + Specs[0].DeclID;
+    LazySpecializationInfo *NewEnd =
+        std::remove_if(Specs + 1, End, [&](const LazySpecializationInfo &S) {
+          if (!S.IsPartial)
+            return false;
+          IDs.push_back(S.DeclID);
+          return true;
+        });
+    Specs[0].DeclID = NewEnd - (Specs + 1);
+  } else {
+    for (uint32_t I = 1, N = Specs[0].DeclID; I <= N; ++I)
+      IDs.push_back(Specs[I].DeclID);
+    CommonBasePtr->LazySpecializations = nullptr;
+  }
+
+  ASTContext &Context = getASTContext();
+  for (uint32_t ID : IDs)
+    (void)Context.getExternalSource()->GetExternalDecl(ID);
+}
+
+void RedeclarableTemplateDecl::loadLazySpecializationsImpl(
+    ArrayRef<TemplateArgument> Args) const {
+  CommonBase *CommonBasePtr = getMostRecentDecl()->getCommonPtr();
+  LazySpecializationInfo *Specs = CommonBasePtr->LazySpecializations;
+  if (!Specs)
+    return;
+
+  // The lazy specializations are sorted by the hash of their arguments; find
+  // the ones that may match and take them out of the array before loading
+  // them, since loading may add more lazy specializations to this template.
+  unsigned Hash = computeSpecializationHash(Args);
+  LazySpecializationInfo *End = Specs + 1 + Specs[0].DeclID;
+  LazySpecializationInfo *First = std::lower_bound(
+      Specs + 1, End, Hash, [](const LazySpecializationInfo &S, unsigned H) {
+        return S.ArgsHash < H;
+      });
+  LazySpecializationInfo *Last = std::upper_bound(
+      First, End, Hash, [](unsigned H, const LazySpecializationInfo &S) {
+        return H < S.ArgsHash;
+      });
+  if (First == Last)
+    return;
+
+  SmallVector<uint32_t, 4> IDs;
+  for (LazySpecializationInfo *S = First; S != Last; ++S)
+    IDs.push_back(S->DeclID);
+  std::copy(Last, End, First);
+  Specs[0].DeclID -= IDs.size();
+
+  ASTContext &Context = getASTContext();
+  for (uint32_t ID : IDs)
+    (void)Context.getExternalSource()->GetExternalDecl(ID);
+}
+
+static void addSpecializationHash(llvm::FoldingSetNodeID &ID,
+                                  const TemplateArgument &Arg);
+
+/// Adds the name of \p D to \p ID. Declarations are identified by name only,
+/// since different AST files may have different declarations of the same
+/// entity.
+static void addSpecializationHash(llvm::FoldingSetNodeID &ID,
+                                  const NamedDecl *D) {
+  if (const IdentifierInfo *II = D ? D->getIdentifier() : nullptr)
+    ID.AddString(II->getName());
+}
+
+/// Adds a coarse description of the structure of \p T to \p ID. Any type
+/// that is not handled below only contributes its type class, so equivalent
+/// types from different AST files always hash equally, and different types
+/// may collide.
+static void addSpecializationHash(llvm::FoldingSetNodeID &ID, QualType T) {
+  T = T.getCanonicalType();
+  ID.AddInteger(T.getCVRQualifiers());
+  const Type *Ty = T.getTypePtr();
+  ID.AddInteger(Ty->getTypeClass());
+
+  if (const auto *BT = dyn_cast<BuiltinType>(Ty)) {
+    ID.AddInteger(BT->getKind());
+  } else if (const auto *PT = dyn_cast<PointerType>(Ty)) {
+    addSpecializationHash(ID, PT->getPointeeType());
+  } else if (const auto *RT = dyn_cast<ReferenceType>(Ty)) {
+    addSpecializationHash(ID, RT->getPointeeType());
+  } else if (const auto *AT = dyn_cast<ArrayType>(Ty)) {
+    addSpecializationHash(ID, AT->getElementType());
+  } else if (const auto *TT = dyn_cast<TagType>(Ty)) {
+    addSpecializationHash(ID, TT->getDecl());
+    if (const auto *Spec =
+            dyn_cast<ClassTemplateSpecializationDecl>(TT->getDecl()))
+      for (const TemplateArgument &Arg : Spec->getTemplateArgs().asArray())
+        addSpecializationHash(ID, Arg);
+  }
+}
+
+static void addSpecializationHash(llvm::FoldingSetNodeID &ID,
+                                  const TemplateArgument &Arg) {
+  ID.AddInteger(Arg.getKind());
+  switch (Arg.getKind()) {
+  case TemplateArgument::Type:
+    addSpecializationHash(ID, Arg.getAsType());
+    break;
+  case TemplateArgument::Declaration:
+    addSpecializationHash(ID, Arg.getAsDecl());
+    break;
+  case TemplateArgument::Integral:
+    Arg.getAsIntegral().Profile(ID);
+    break;
+  case TemplateArgument::Template:
+  case TemplateArgument::TemplateExpansion:
+    addSpecializationHash(
+        ID, Arg.getAsTemplateOrTemplatePattern().getAsTemplateDecl());
+    break;
+  case TemplateArgument::Pack:
+    for (const TemplateArgument &Element : Arg.pack_elements())
+      addSpecializationHash(ID, Element);
+    break;
+  case TemplateArgument::Null:
+  case TemplateArgument::NullPtr:
+  case TemplateArgument::Expression:
+    break;
+  }
+}
+
+unsigned RedeclarableTemplateDecl::computeSpecializationHash(
+    ArrayRef<TemplateArgument> Args) const {
+  llvm::FoldingSetNodeID ID;
+  for (const TemplateArgument &Arg : Args)
+    addSpecializationHash(ID, Arg);
+  return ID.ComputeHash();
+}
+
+unsigned
+RedeclarableTemplateDecl::computeSpecializationHash(const Decl *D) const {
+  if (auto *CTSD = dyn_cast<ClassTemplateSpecializationDecl>(D))
+    return computeSpecializationHash(CTSD->getTemplateArgs().asArray());
+  if (auto *VTSD = dyn_cast<VarTemplateSpecializationDecl>(D))
+    return computeSpecializationHash(VTSD->getTemplateArgs().asArray());
+  return computeSpecializationHash(
+      cast<FunctionDecl>(D)->getTemplateSpecializationArgs()->asArray());
+}
+
 template<class EntryType>
 typename RedeclarableTemplateDecl::SpecEntryTraits<EntryType>::DeclType *
 RedeclarableTemplateDecl::findSpecializationImpl(
@@ -232,18 +389,7 @@ FunctionTemplateDecl::newCommon(ASTContext &C) const {
 }
 
 void FunctionTemplateDecl::LoadLazySpecializations() const {
-  // Grab the most recent declaration to ensure we've loaded any lazy
-  // redeclarations of this template.
-  //
-  // FIXME: Avoid walking the entire redeclaration chain here.
-  Common *CommonPtr = getMostRecentDecl()->getCommonPtr();
-  if (CommonPtr->LazySpecializations) {
-    ASTContext &Context = getASTContext();
-    uint32_t *Specs = CommonPtr->LazySpecializations;
-    CommonPtr->LazySpecializations = nullptr;
-    for (uint32_t I = 0, N = *Specs++; I != N; ++I)
-      (void)Context.getExternalSource()->GetExternalDecl(Specs[I]);
-  }
+  loadLazySpecializationsImpl();
 }
 
 llvm::FoldingSetVector<FunctionTemplateSpecializationInfo> &
@@ -255,13 +401,19 @@ FunctionTemplateDecl::getSpecializations() const {
 FunctionDecl *
 FunctionTemplateDecl::findSpecialization(ArrayRef<TemplateArgument> Args,
                                          void *&InsertPos) {
-  return findSpecializationImpl(getSpecializations(), Args, InsertPos);
+  loadLazySpecializationsImpl(Args);
+  return findSpecializationImpl(getCommonPtr()->Specializations, Args,
+                                InsertPos);
 }
 
 void FunctionTemplateDecl::addSpecialization(
       FunctionTemplateSpecializationInfo *Info, void *InsertPos) {
-  addSpecializationImpl<FunctionTemplateDecl>(getSpecializations(), Info,
-                                              InsertPos);
+  // A valid InsertPos comes from findSpecialization(), which loaded the
+  // specializations that may have the same arguments.
+  if (!InsertPos)
+    loadLazySpecializationsImpl(Info->TemplateArguments->asArray());
+  addSpecializationImpl<FunctionTemplateDecl>(getCommonPtr()->Specializations,
+                                              Info, InsertPos);
 }
 
 ArrayRef<TemplateArgument> FunctionTemplateDecl::getInjectedTemplateArgs() {
@@ -311,18 +463,7 @@ ClassTemplateDecl *ClassTemplateDecl::CreateDeserialized(ASTContext &C,
 }
 
 void ClassTemplateDecl::LoadLazySpecializations() const {
-  // Grab the most recent declaration to ensure we've loaded any lazy
-  // redeclarations of this template.
-  //
-  // FIXME: Avoid walking the entire redeclaration chain here.
-  Common *CommonPtr = getMostRecentDecl()->getCommonPtr();
-  if (CommonPtr->LazySpecializations) {
-    ASTContext &Context = getASTContext();
-    uint32_t *Specs = CommonPtr->LazySpecializations;
-    CommonPtr->LazySpecializations = nullptr;
-    for (uint32_t I = 0, N = *Specs++; I != N; ++I)
-      (void)Context.getExternalSource()->GetExternalDecl(Specs[I]);
-  }
+  loadLazySpecializationsImpl();
 }
 
 llvm::FoldingSetVector<ClassTemplateSpecializationDecl> &
@@ -333,7 +474,7 @@ ClassTemplateDecl::getSpecializations() const {
 
 llvm::FoldingSetVector<ClassTemplatePartialSpecializationDecl> &
 ClassTemplateDecl::getPartialSpecializations() {
-  LoadLazySpecializations();
+  loadLazySpecializationsImpl(/*OnlyPartial=*/true);
   return getCommonPtr()->PartialSpecializations;
 }  
 
@@ -347,12 +488,19 @@ ClassTemplateDecl::newCommon(ASTContext &C) const {
 ClassTemplateSpecializationDecl *
 ClassTemplateDecl::findSpecialization(ArrayRef<TemplateArgument> Args,
                                       void *&InsertPos) {
-  return findSpecializationImpl(getSpecializations(), Args, InsertPos);
+  loadLazySpecializationsImpl(Args);
+  return findSpecializationImpl(getCommonPtr()->Specializations, Args,
+                                InsertPos);
 }
 
 void ClassTemplateDecl::AddSpecialization(ClassTemplateSpecializationDecl *D,
                                           void *InsertPos) {
-  addSpecializationImpl<ClassTemplateDecl>(getSpecializations(), D, InsertPos);
+  // A valid InsertPos comes from findSpecialization(), which loaded the
+  // specializations that may have the same arguments.
+  if (!InsertPos)
+    loadLazySpecializationsImpl(D->getTemplateArgs().asArray());
+  addSpecializationImpl<ClassTemplateDecl>(getCommonPtr()->Specializations, D,
+                                           InsertPos);
 }
 
 ClassTemplatePartialSpecializationDecl *
@@ -927,21 +1075,8 @@ VarTemplateDecl *VarTemplateDecl::CreateDeserialized(ASTContext &C,
                                      DeclarationName(), nullptr, nullptr);
 }
 
-// TODO: Unify across class, function and variable templates?
-//       May require moving this and Common to RedeclarableTemplateDecl.
 void VarTemplateDecl::LoadLazySpecializations() const {
-  // Grab the most recent declaration to ensure we've loaded any lazy
-  // redeclarations of this template.
-  //
-  // FIXME: Avoid walking the entire redeclaration chain here.
-  Common *CommonPtr = getMostRecentDecl()->getCommonPtr();
-  if (CommonPtr->LazySpecializations) {
-    ASTContext &Context = getASTContext();
-    uint32_t *Specs = CommonPtr->LazySpecializations;
-    CommonPtr->LazySpecializations = nullptr;
-    for (uint32_t I = 0, N = *Specs++; I != N; ++I)
-      (void)Context.getExternalSource()->GetExternalDecl(Specs[I]);
-  }
+  loadLazySpecializationsImpl();
 }
 
 llvm::FoldingSetVector<VarTemplateSpecializationDecl> &
@@ -952,7 +1087,7 @@ VarTemplateDecl::getSpecializations() const {
 
 llvm::FoldingSetVector<VarTemplatePartialSpecializationDecl> &
 VarTemplateDecl::getPartialSpecializations() {
-  LoadLazySpecializations();
+  loadLazySpecializationsImpl(/*OnlyPartial=*/true);
   return getCommonPtr()->PartialSpecializations;
 }
 
@@ -966,12 +1101,19 @@ VarTemplateDecl::newCommon(ASTContext &C) const {
 VarTemplateSpecializationDecl *
 VarTemplateDecl::findSpecialization(ArrayRef<TemplateArgument> Args,
                                     void *&InsertPos) {
-  return findSpecializationImpl(getSpecializations(), Args, InsertPos);
+  loadLazySpecializationsImpl(Args);
+  return findSpecializationImpl(getCommonPtr()->Specializations, Args,
+                                InsertPos);
 }
 
 void VarTemplateDecl::AddSpecialization(VarTemplateSpecializationDecl *D,
                                         void *InsertPos) {
-  addSpecializationImpl<VarTemplateDecl>(getSpecializations(), D, InsertPos);
+  // A valid InsertPos comes from findSpecialization(), which loaded the
+  // specializations that may have the same arguments.
+  if (!InsertPos)
+    loadLazySpecializationsImpl(D->getTemplateArgs().asArray());
+  addSpecializationImpl<VarTemplateDecl>(getCommonPtr()->Specializations, D,
+                                         InsertPos);
 }
 
 VarTemplatePartialSpecializationDecl *
@@ -21,6 +21,7 @@
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Timer.h"
 #include <deque>
@@ -306,13 +307,25 @@ class MatchASTVisitor : public RecursiveASTVisitor<MatchASTVisitor>,
                         public ASTMatchFinder {
 public:
   MatchASTVisitor(const MatchFinder::MatchersByType *Matchers,
+                  MatchFinder::MatcherFiltersByKind &MatcherFiltersMap,
                   const MatchFinder::MatchFinderOptions &Options)
-      : Matchers(Matchers), Options(Options), ActiveASTContext(nullptr) {}
+      : Matchers(Matchers), MatcherFiltersMap(MatcherFiltersMap),
+        Options(Options), ActiveASTContext(nullptr) {
+    if (Options.CheckProfiling && Options.CheckProfiling->MatcherRecords)
+      createMatcherBuckets();
+  }
 
   ~MatchASTVisitor() override {
-    if (Options.CheckProfiling) {
-      Options.CheckProfiling->Records = std::move(TimeByBucket);
+    if (!Options.CheckProfiling)
+      return;
+    auto &Profiling = *Options.CheckProfiling;
+    // Per matcher time also counts towards the bucket of its callback.
+    for (const auto &Entry : TimeByMatcher) {
+      TimeByBucket[Entry.getKey().rsplit('/').first] += Entry.getValue();
+      (*Profiling.MatcherRecords)[Entry.getKey()] += Entry.getValue();
     }
+    for (const auto &Entry : TimeByBucket)
+      Profiling.Records[Entry.getKey()] += Entry.getValue();
   }
 
   void onStartOfTranslationUnit() {
@@ -529,6 +542,43 @@ private:
     llvm::TimeRecord *Bucket;
   };
 
+  /// \brief Creates a named time bucket for every registered matcher.
+  ///
+  /// Matchers are named after their callback, the node kind they are
+  /// restricted to and their position among the matchers of that callback
+  /// with the same kind, e.g. "misc-foo/CallExpr#1".
+  void createMatcherBuckets() {
+    llvm::StringMap<unsigned> Counts;
+    auto Create = [&](const void *Entry, const DynTypedMatcher &Matcher,
+                      MatchCallback *Callback) {
+      std::string Name = (Callback->getID() + "/" +
+                          Matcher.getID().first.asStringRef()).str();
+      unsigned Index = Counts[Name]++;
+      BucketByMatcher[Entry] =
+          &TimeByMatcher[Name + "#" + llvm::utostr(Index)];
+    };
+    for (const auto &MP : Matchers->DeclOrStmt)
+      Create(&MP, MP.first, MP.second);
+    for (const auto &MP : Matchers->Type)
+      Create(&MP, MP.first, MP.second);
+    for (const auto &MP : Matchers->NestedNameSpecifier)
+      Create(&MP, MP.first, MP.second);
+    for (const auto &MP : Matchers->NestedNameSpecifierLoc)
+      Create(&MP, MP.first, MP.second);
+    for (const auto &MP : Matchers->TypeLoc)
+      Create(&MP, MP.first, MP.second);
+    for (const auto &MP : Matchers->CtorInit)
+      Create(&MP, MP.first, MP.second);
+  }
+
+  /// \brief Returns the bucket the time spent running \p MP is recorded in.
+  template <typename MatcherPair>
+  llvm::TimeRecord *getTimeBucket(const MatcherPair &MP) {
+    if (Options.CheckProfiling->MatcherRecords)
+      return BucketByMatcher.lookup(&MP);
+    return &TimeByBucket[MP.second->getID()];
+  }
+
   /// \brief Runs all the \p Matchers on \p Node.
   ///
   /// Used by \c matchDispatch() below.
@@ -538,7 +588,7 @@ private:
     TimeBucketRegion Timer;
     for (const auto &MP : Matchers) {
       if (EnableCheckProfiling)
-        Timer.setBucket(&TimeByBucket[MP.second->getID()]);
+        Timer.setBucket(getTimeBucket(MP));
       BoundNodesTreeBuilder Builder;
       if (MP.first.matches(Node, this, &Builder)) {
         MatchVisitor Visitor(ActiveASTContext, MP.second);
@@ -559,10 +609,13 @@ private:
     const bool EnableCheckProfiling = Options.CheckProfiling.hasValue();
     TimeBucketRegion Timer;
     auto &Matchers = this->Matchers->DeclOrStmt;
+    // The callbacks may call match() on the finder again, which can grow the
+    // shared map. That moves the filter vectors but not their elements, so the
+    // iterators used here stay valid.
     for (unsigned short I : Filter) {
       auto &MP = Matchers[I];
       if (EnableCheckProfiling)
-        Timer.setBucket(&TimeByBucket[MP.second->getID()]);
+        Timer.setBucket(getTimeBucket(MP));
       BoundNodesTreeBuilder Builder;
       if (MP.first.matchesNoKindCheck(DynNode, this, &Builder)) {
         MatchVisitor Visitor(ActiveASTContext, MP.second);
@@ -749,6 +802,14 @@ private:
   /// Used to get the appropriate bucket for each matcher.
   llvm::StringMap<llvm::TimeRecord> TimeByBucket;
 
+  /// \brief Per matcher time records, see \c createMatcherBuckets().
+  ///
+  /// Only populated if per matcher profiling is enabled.
+  llvm::StringMap<llvm::TimeRecord> TimeByMatcher;
+
+  /// \brief Maps each entry of \c Matchers to its bucket in \c TimeByMatcher.
+  llvm::DenseMap<const void *, llvm::TimeRecord *> BucketByMatcher;
+
   const MatchFinder::MatchersByType *Matchers;
 
   /// \brief Filtered list of matcher indices for each matcher kind.
@@ -759,8 +820,9 @@ private:
   /// We precalculate a list of matchers that pass the toplevel restrict check.
   /// This also allows us to skip the restrict check at matching time. See
   /// use \c matchesNoKindCheck() above.
-  llvm::DenseMap<ast_type_traits::ASTNodeKind, std::vector<unsigned short>>
-      MatcherFiltersMap;
+  /// The lists are owned by the \c MatchFinder, so they are reused across
+  /// translation units.
+  MatchFinder::MatcherFiltersByKind &MatcherFiltersMap;
 
   const MatchFinder::MatchFinderOptions &Options;
   ASTContext *ActiveASTContext;
@@ -931,6 +993,7 @@ void MatchFinder::addMatcher(const DeclarationMatcher &NodeMatch,
                              MatchCallback *Action) {
   Matchers.DeclOrStmt.emplace_back(NodeMatch, Action);
   Matchers.AllCallbacks.insert(Action);
+  MatcherFilters.clear();
 }
 
 void MatchFinder::addMatcher(const TypeMatcher &NodeMatch,
@@ -943,6 +1006,7 @@ void MatchFinder::addMatcher(const StatementMatcher &NodeMatch,
                              MatchCallback *Action) {
   Matchers.DeclOrStmt.emplace_back(NodeMatch, Action);
   Matchers.AllCallbacks.insert(Action);
+  MatcherFilters.clear();
 }
 
 void MatchFinder::addMatcher(const NestedNameSpecifierMatcher &NodeMatch,
@@ -1002,13 +1066,13 @@ std::unique_ptr<ASTConsumer> MatchFinder::newASTConsumer() {
 
 void MatchFinder::match(const clang::ast_type_traits::DynTypedNode &Node,
                         ASTContext &Context) {
-  internal::MatchASTVisitor Visitor(&Matchers, Options);
+  internal::MatchASTVisitor Visitor(&Matchers, MatcherFilters, Options);
   Visitor.set_active_ast_context(&Context);
   Visitor.match(Node);
 }
 
 void MatchFinder::matchAST(ASTContext &Context) {
-  internal::MatchASTVisitor Visitor(&Matchers, Options);
+  internal::MatchASTVisitor Visitor(&Matchers, MatcherFilters, Options);
   Visitor.set_active_ast_context(&Context);
   Visitor.onStartOfTranslationUnit();
   Visitor.TraverseDecl(Context.getTranslationUnitDecl());
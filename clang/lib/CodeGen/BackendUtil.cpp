@@ -24,10 +24,13 @@
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/CodeGen/RegAllocRegistry.h"
 #include "llvm/CodeGen/SchedulerRegistry.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/IRPrintingPasses.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
@@ -39,7 +42,9 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -54,9 +59,11 @@
 #include "llvm/Transforms/ObjCARC.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/NameAnonGlobals.h"
 #include "llvm/Transforms/Utils/SymbolRewriter.h"
 #include <memory>
+#include <mutex>
 using namespace clang;
 using namespace llvm;
 
@@ -96,6 +103,19 @@ class EmitAssemblyHelper {
   /// the requested target.
   void CreateTargetMachine(bool MustCreateTM);
 
+  /// Creates a TargetMachine for the given triple, or returns null and sets
+  /// \p Error if the target is not available.
+  std::unique_ptr<TargetMachine>
+  createTargetMachine(const std::string &Triple, std::string &Error) const;
+
+  /// Whether the object code should be generated in parallel, by splitting
+  /// the module into the partitions requested with -parallel-codegen-output.
+  bool shouldEmitObjectInParallel(BackendAction Action) const;
+
+  /// Splits the optimized module and generates the object code of the
+  /// partitions in parallel, writing the first partition to \p OS.
+  void EmitObjectInParallel(raw_pwrite_stream &OS);
+
   /// Add passes necessary to emit assembly or LLVM IR.
   ///
   /// \return True on success.
@@ -649,13 +669,17 @@ static void setCommandLineOpts(const CodeGenOptions &CodeGenOpts) {
 void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
   // Create the TargetMachine for generating code.
   std::string Error;
-  std::string Triple = TheModule->getTargetTriple();
+  TM = createTargetMachine(TheModule->getTargetTriple(), Error);
+  if (!TM && MustCreateTM)
+    Diags.Report(diag::err_fe_unable_to_create_target) << Error;
+}
+
+std::unique_ptr<TargetMachine>
+EmitAssemblyHelper::createTargetMachine(const std::string &Triple,
+                                        std::string &Error) const {
   const llvm::Target *TheTarget = TargetRegistry::lookupTarget(Triple, Error);
-  if (!TheTarget) {
-    if (MustCreateTM)
-      Diags.Report(diag::err_fe_unable_to_create_target) << Error;
-    return;
-  }
+  if (!TheTarget)
+    return nullptr;
 
   llvm::CodeModel::Model CM  = getCodeModel(CodeGenOpts);
   std::string FeaturesStr =
@@ -665,8 +689,8 @@ void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
 
   llvm::TargetOptions Options;
   initTargetOptions(Options, CodeGenOpts, TargetOpts, LangOpts, HSOpts);
-  TM.reset(TheTarget->createTargetMachine(Triple, TargetOpts.CPU, FeaturesStr,
-                                          Options, RM, CM, OptLevel));
+  return std::unique_ptr<TargetMachine>(TheTarget->createTargetMachine(
+      Triple, TargetOpts.CPU, FeaturesStr, Options, RM, CM, OptLevel));
 }
 
 bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
@@ -697,6 +721,97 @@ bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
   return true;
 }
 
+bool EmitAssemblyHelper::shouldEmitObjectInParallel(
+    BackendAction Action) const {
+  // Every requested partition is written, even if some of them end up
+  // empty, since the driver links all of them.
+  return Action == Backend_EmitObj &&
+         !CodeGenOpts.ParallelCodeGenOutputs.empty();
+}
+
+namespace {
+/// Forwards the diagnostics of the contexts of the partitions to the handlers
+/// of the context of the module being code generated.
+struct PartitionDiagnostics {
+  LLVMContext &Ctx;
+  std::mutex Lock;
+
+  PartitionDiagnostics(LLVMContext &Ctx) : Ctx(Ctx) {}
+
+  static void handleDiagnostic(const DiagnosticInfo &DI, void *Context) {
+    auto *Forward = static_cast<PartitionDiagnostics *>(Context);
+    std::lock_guard<std::mutex> Guard(Forward->Lock);
+    Forward->Ctx.diagnose(DI);
+  }
+
+  static void handleInlineAsmDiagnostic(const llvm::SMDiagnostic &D,
+                                        void *Context, unsigned LocCookie) {
+    auto *Forward = static_cast<PartitionDiagnostics *>(Context);
+    std::lock_guard<std::mutex> Guard(Forward->Lock);
+    if (LLVMContext::InlineAsmDiagHandlerTy Handler =
+            Forward->Ctx.getInlineAsmDiagnosticHandler())
+      Handler(D, Forward->Ctx.getInlineAsmDiagnosticContext(), LocCookie);
+    else
+      D.print(nullptr, errs());
+  }
+};
+} // end anonymous namespace
+
+void EmitAssemblyHelper::EmitObjectInParallel(raw_pwrite_stream &OS) {
+  std::vector<std::unique_ptr<raw_fd_ostream>> PartitionOSs;
+  SmallVector<raw_pwrite_stream *, 8> OSs;
+  OSs.push_back(&OS);
+  for (const std::string &Path : CodeGenOpts.ParallelCodeGenOutputs) {
+    std::error_code EC;
+    PartitionOSs.push_back(
+        llvm::make_unique<raw_fd_ostream>(Path, EC, llvm::sys::fs::F_None));
+    if (EC) {
+      Diags.Report(diag::err_fe_unable_to_open_output) << Path << EC.message();
+      return;
+    }
+    OSs.push_back(PartitionOSs.back().get());
+  }
+
+  // Run the ObjC ARC final cleanup that AddEmitPasses adds to the code
+  // generation passes.
+  if (CodeGenOpts.OptimizationLevel > 0) {
+    legacy::PassManager ARCPasses;
+    ARCPasses.add(createObjCARCContractPass());
+    ARCPasses.run(*TheModule);
+  }
+
+  // The partitions are code generated in their own contexts, so this only
+  // reads the options of the helper.
+  std::string Triple = TheModule->getTargetTriple();
+  auto TMFactory = [this, Triple]() {
+    std::string Error;
+    return createTargetMachine(Triple, Error);
+  };
+
+  // Each partition gets the library info of the command line, e.g. for
+  // -fno-builtin, and reports its diagnostics through the handlers of the
+  // module's context, one partition at a time.
+  llvm::Triple TargetTriple(Triple);
+  std::unique_ptr<TargetLibraryInfoImpl> TLII(
+      createTLII(TargetTriple, CodeGenOpts));
+  PartitionDiagnostics Forward(TheModule->getContext());
+  auto PartitionSetup = [&](LLVMContext &Ctx, legacy::PassManagerBase &PM) {
+    PM.add(new TargetLibraryInfoWrapperPass(*TLII));
+    Ctx.setDiagnosticHandler(PartitionDiagnostics::handleDiagnostic, &Forward);
+    Ctx.setInlineAsmDiagnosticHandler(
+        PartitionDiagnostics::handleInlineAsmDiagnostic, &Forward);
+    Ctx.setDiagnosticsHotnessRequested(
+        Forward.Ctx.getDiagnosticsHotnessRequested());
+  };
+
+  // The module is still owned by the caller, so split a copy of it. Local
+  // symbols are preserved, as the partitions are linked into an object file
+  // that is later linked with the rest of the program.
+  splitCodeGen(CloneModule(TheModule), OSs, {}, TMFactory,
+               TargetMachine::CGFT_ObjectFile, /*PreserveLocals=*/true,
+               PartitionSetup);
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
                                       std::unique_ptr<raw_pwrite_stream> OS) {
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : nullptr);
@@ -760,6 +875,8 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
     break;
 
   default:
+    if (shouldEmitObjectInParallel(Action))
+      break;
     if (!AddEmitPasses(CodeGenPasses, Action, *OS))
       return;
   }
@@ -772,6 +889,7 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   {
     PrettyStackTraceString CrashInfo("Per-function optimization");
+    llvm::TimeTraceScope TimeScope("PerFunctionPasses");
 
     PerFunctionPasses.doInitialization();
     for (Function &F : *TheModule)
@@ -782,12 +900,17 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   {
     PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    llvm::TimeTraceScope TimeScope("PerModulePasses");
     PerModulePasses.run(*TheModule);
   }
 
   {
     PrettyStackTraceString CrashInfo("Code generation");
-    CodeGenPasses.run(*TheModule);
+    llvm::TimeTraceScope TimeScope("CodeGenPasses");
+    if (shouldEmitObjectInParallel(Action))
+      EmitObjectInParallel(*OS);
+    else
+      CodeGenPasses.run(*TheModule);
   }
 }
 
@@ -949,6 +1072,8 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   case Backend_EmitMCNull:
   case Backend_EmitObj:
     NeedCodeGen = true;
+    if (shouldEmitObjectInParallel(Action))
+      break;
     CodeGenPasses.add(
         createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
     if (!AddEmitPasses(CodeGenPasses, Action, *OS))
@@ -963,13 +1088,18 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   // Now that we have all of the passes ready, run them.
   {
     PrettyStackTraceString CrashInfo("Optimizer");
+    llvm::TimeTraceScope TimeScope("Optimizer");
     MPM.run(*TheModule, MAM);
   }
 
   // Now if needed, run the legacy PM for codegen.
   if (NeedCodeGen) {
     PrettyStackTraceString CrashInfo("Code generation");
-    CodeGenPasses.run(*TheModule);
+    llvm::TimeTraceScope TimeScope("CodeGenPasses");
+    if (shouldEmitObjectInParallel(Action))
+      EmitObjectInParallel(*OS);
+    else
+      CodeGenPasses.run(*TheModule);
   }
 }
 
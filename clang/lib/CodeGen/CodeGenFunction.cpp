@@ -35,6 +35,7 @@
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/Support/TimeProfiler.h"
 using namespace clang;
 using namespace CodeGen;
 
@@ -1124,6 +1125,10 @@ void CodeGenFunction::GenerateCode(GlobalDecl GD, llvm::Function *Fn,
   const FunctionDecl *FD = cast<FunctionDecl>(GD.getDecl());
   CurGD = GD;
 
+  llvm::TimeTraceScope TimeScope("CodeGen Function", [&]() {
+    return FD->getQualifiedNameAsString();
+  });
+
   FunctionArgList Args;
   QualType ResTy = BuildFunctionArgList(GD, Args);
 
@@ -1206,6 +1206,7 @@ void Clang::AddPreprocessingOptions(Compilation &C, const JobAction &JA,
   Args.AddAllArgs(CmdArgs,
                   {options::OPT_D, options::OPT_U, options::OPT_I_Group,
                    options::OPT_F, options::OPT_index_header_map});
+  Args.AddLastArg(CmdArgs, options::OPT_fheader_search_cache_EQ);
 
   // Add -Wp, and -Xpreprocessor if using the preprocessor.
 
@@ -3271,6 +3272,8 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_print_source_range_info);
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_parseable_fixits);
   Args.AddLastArg(CmdArgs, options::OPT_ftime_report);
+  Args.AddLastArg(CmdArgs, options::OPT_ftime_trace);
+  Args.AddLastArg(CmdArgs, options::OPT_ftime_trace_granularity_EQ);
   Args.AddLastArg(CmdArgs, options::OPT_ftrapv);
 
   if (Arg *A = Args.getLastArg(options::OPT_ftrapv_handler_EQ)) {
@@ -3650,6 +3653,7 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   }
 
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_validate_system_headers);
+  Args.AddLastArg(CmdArgs, options::OPT_fmodules_lazy_validate_input_files);
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_disable_diagnostic_validation);
 
   // -faccess-control is default.
@@ -4341,8 +4345,44 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       isa<CompileJobAction>(JA))
     CmdArgs.push_back("-disable-llvm-passes");
 
+  // With -fparallel-codegen=N, cc1 splits the module and writes the object
+  // code of each partition to a temporary file, and the partitions are then
+  // combined into the output with a relocatable link.
+  SmallVector<const char *, 8> CodeGenPartitions;
+  if (Arg *A = Args.getLastArg(options::OPT_fparallel_codegen_EQ)) {
+    StringRef Value = A->getValue();
+    unsigned NumPartitions;
+    if (Value.getAsInteger(10, NumPartitions) || NumPartitions == 0)
+      D.Diag(diag::err_drv_invalid_int_value) << A->getAsString(Args) << Value;
+    else if (!Triple.isOSBinFormatELF())
+      D.Diag(diag::err_drv_unsupported_opt_for_target) << A->getAsString(Args)
+                                                        << TripleStr;
+    else if (NumPartitions > 1 && Output.getType() == types::TY_Object &&
+             Output.isFilename()) {
+      StringRef Stem = llvm::sys::path::stem(Input.getBaseInput());
+      for (unsigned I = 0; I != NumPartitions; ++I)
+        CodeGenPartitions.push_back(C.addTempFile(
+            Args.MakeArgString(D.GetTemporaryPath(Stem, "o"))));
+    }
+  }
+
   if (Output.getType() == types::TY_Dependencies) {
     // Handled with other dependency code.
+  } else if (!CodeGenPartitions.empty()) {
+    CmdArgs.push_back("-o");
+    CmdArgs.push_back(CodeGenPartitions.front());
+    for (const char *Partition : makeArrayRef(CodeGenPartitions).slice(1)) {
+      CmdArgs.push_back("-parallel-codegen-output");
+      CmdArgs.push_back(Partition);
+    }
+    // The output of cc1 is a temporary partition; keep the time trace next
+    // to the final object file.
+    if (Args.hasArg(options::OPT_ftime_trace)) {
+      SmallString<128> TimeTraceFile(Output.getFilename());
+      llvm::sys::path::replace_extension(TimeTraceFile, "json");
+      CmdArgs.push_back(
+          Args.MakeArgString(Twine("-time-trace-file=") + TimeTraceFile));
+    }
   } else if (Output.isFilename()) {
     CmdArgs.push_back("-o");
     CmdArgs.push_back(Output.getFilename());
@@ -4466,6 +4506,18 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     C.addCommand(llvm::make_unique<Command>(JA, *this, Exec, CmdArgs, Inputs));
   }
 
+  if (!CodeGenPartitions.empty()) {
+    ArgStringList LinkArgs;
+    LinkArgs.push_back("-r");
+    LinkArgs.push_back("-o");
+    LinkArgs.push_back(Output.getFilename());
+    LinkArgs.append(CodeGenPartitions.begin(), CodeGenPartitions.end());
+    const char *LinkerExec =
+        Args.MakeArgString(getToolChain().GetLinkerPath());
+    C.addCommand(
+        llvm::make_unique<Command>(JA, *this, LinkerExec, LinkArgs, Inputs));
+  }
+
   // Handle the debug info splitting at object creation time if we're
   // creating an object.
   // TODO: Currently only works on linux with newer objcopy.
@@ -976,10 +976,17 @@ public:
     deriveLocalStyle(AnnotatedLines);
     AffectedRangeMgr.computeAffectedLines(AnnotatedLines.begin(),
                                           AnnotatedLines.end());
-    for (unsigned i = 0, e = AnnotatedLines.size(); i != e; ++i) {
+    // Formatting a few ranges of a large file only needs to look at the
+    // declarations around them.
+    unsigned Begin, End;
+    std::tie(Begin, End) =
+        UnwrappedLineFormatter::getFormattingRange(AnnotatedLines, Style);
+    for (unsigned i = Begin; i != End; ++i) {
       Annotator.calculateFormattingInformation(*AnnotatedLines[i]);
     }
     Annotator.setCommentLineLevels(AnnotatedLines);
+    if (Begin == End)
+      return Result;
 
     WhitespaceManager Whitespaces(
         Env.getSourceManager(), Style,
@@ -989,7 +996,7 @@ public:
                                   BinPackInconclusiveFunctions);
     UnwrappedLineFormatter(&Indenter, &Whitespaces, Style, Tokens.getKeywords(),
                            Env.getSourceManager(), Status)
-        .format(AnnotatedLines);
+        .formatRange(AnnotatedLines, Begin, End);
     for (const auto &R : Whitespaces.generateReplacements())
       if (Result.add(R))
         return Result;
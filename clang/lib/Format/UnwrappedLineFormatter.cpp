@@ -9,6 +9,7 @@
 
 #include "UnwrappedLineFormatter.h"
 #include "WhitespaceManager.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include <queue>
 
@@ -19,6 +20,20 @@ namespace format {
 
 namespace {
 
+/// \brief The number of states after which the analysis of a line stops
+/// looking for the best solution, and completes the cheapest one found so far
+/// greedily.
+///
+/// This bounds the time and memory spent on pathological lines, e.g. long
+/// initializer lists with nested lambdas, for which even ignoring the stack
+/// when comparing states (see \c IgnoreStackForComparison) does not keep the
+/// solution space small. Every state holds a copy of the paren stack, so the
+/// bound is kept within a small multiple of that cut-off.
+llvm::cl::opt<unsigned> MaxStatesToAnalyze(
+    "format-max-states", llvm::cl::Hidden, llvm::cl::init(100000),
+    llvm::cl::desc("The number of states after which the formatting of a "
+                   "line is completed greedily"));
+
 bool startsExternCBlock(const AnnotatedLine &Line) {
   const FormatToken *Next = Line.First->getNextNonComment();
   const FormatToken *NextNext = Next ? Next->getNextNonComment() : nullptr;
@@ -153,9 +168,10 @@ bool isEndOfNamespace(const AnnotatedLine *Line,
 class LineJoiner {
 public:
   LineJoiner(const FormatStyle &Style, const AdditionalKeywords &Keywords,
-             const SmallVectorImpl<AnnotatedLine *> &Lines)
-      : Style(Style), Keywords(Keywords), End(Lines.end()), Next(Lines.begin()),
-        AnnotatedLines(Lines) {}
+             const SmallVectorImpl<AnnotatedLine *> &Lines, unsigned BeginLine,
+             unsigned EndLine)
+      : Style(Style), Keywords(Keywords), End(Lines.begin() + EndLine),
+        Next(Lines.begin() + BeginLine), AnnotatedLines(Lines) {}
 
   /// \brief Returns the next line, merging multiple lines into one if possible.
   const AnnotatedLine *getNextMergedLine(bool DryRun,
@@ -765,6 +781,9 @@ private:
   typedef std::priority_queue<QueueItem, std::vector<QueueItem>,
                               std::greater<QueueItem>> QueueType;
 
+  /// \brief The set of states that have already been examined.
+  typedef std::set<LineState *, CompareLineStatePointers> SeenSet;
+
   /// \brief Analyze the entire solution space starting from \p InitialState.
   ///
   /// This implements a variant of Dijkstra's algorithm on the graph that spans
@@ -774,7 +793,7 @@ private:
   ///
   /// If \p DryRun is \c false, directly applies the changes.
   unsigned analyzeSolutionSpace(LineState &InitialState, bool DryRun) {
-    std::set<LineState *, CompareLineStatePointers> Seen;
+    SeenSet Seen;
 
     // Increasing count of \c StateNode items we have created. This is used to
     // create a deterministic order independent of the container.
@@ -788,6 +807,7 @@ private:
     ++Count;
 
     unsigned Penalty = 0;
+    StateNode *Solution = nullptr;
 
     // While not empty, take first element and follow edges.
     while (!Queue.empty()) {
@@ -795,6 +815,7 @@ private:
       StateNode *Node = Queue.top().second;
       if (!Node->State.NextToken) {
         DEBUG(llvm::dbgs() << "\n---\nPenalty for line: " << Penalty << "\n");
+        Solution = Node;
         break;
       }
       Queue.pop();
@@ -808,14 +829,22 @@ private:
         // State already examined with lower penalty.
         continue;
 
+      if (Count > MaxStatesToAnalyze) {
+        DEBUG(llvm::dbgs() << "Too many states, completing greedily.\n");
+        Solution = completeGreedily(Node, Penalty, &Count);
+        break;
+      }
+
       FormatDecision LastFormat = Node->State.NextToken->Decision;
       if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
-        addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue);
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue,
+                            &Seen);
       if (LastFormat == FD_Unformatted || LastFormat == FD_Break)
-        addNextStateToQueue(Penalty, Node, /*NewLine=*/true, &Count, &Queue);
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/true, &Count, &Queue,
+                            &Seen);
     }
 
-    if (Queue.empty()) {
+    if (!Solution) {
       // We were unable to find a solution, do nothing.
       // FIXME: Add diagnostic?
       DEBUG(llvm::dbgs() << "Could not find a solution.\n");
@@ -824,7 +853,7 @@ private:
 
     // Reconstruct the solution.
     if (!DryRun)
-      reconstructPath(InitialState, Queue.top().second);
+      reconstructPath(InitialState, Solution);
 
     DEBUG(llvm::dbgs() << "Total number of analyzed states: " << Count << "\n");
     DEBUG(llvm::dbgs() << "---\n");
@@ -832,25 +861,55 @@ private:
     return Penalty;
   }
 
+  /// \brief Completes the solution starting at \p Node, which has been
+  /// reached with a penalty of \p Penalty, by placing each remaining token
+  /// the cheapest way.
+  ///
+  /// Updates \p Penalty and returns the final node, or null if a token cannot
+  /// be placed.
+  StateNode *completeGreedily(StateNode *Node, unsigned &Penalty,
+                              unsigned *Count) {
+    while (Node->State.NextToken) {
+      QueueType Choices;
+      FormatDecision LastFormat = Node->State.NextToken->Decision;
+      if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/false, Count, &Choices);
+      if (LastFormat == FD_Unformatted || LastFormat == FD_Break)
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/true, Count, &Choices);
+      if (Choices.empty())
+        return nullptr;
+      Penalty = Choices.top().first.first;
+      Node = Choices.top().second;
+    }
+    return Node;
+  }
+
   /// \brief Add the following state to the analysis queue \c Queue.
   ///
   /// Assume the current state is \p PreviousNode and has been reached with a
   /// penalty of \p Penalty. Insert a line break if \p NewLine is \c true.
+  /// States in \p Seen have already been examined with a lower penalty and
+  /// are not added again.
   void addNextStateToQueue(unsigned Penalty, StateNode *PreviousNode,
-                           bool NewLine, unsigned *Count, QueueType *Queue) {
+                           bool NewLine, unsigned *Count, QueueType *Queue,
+                           const SeenSet *Seen = nullptr) {
     if (NewLine && !Indenter->canBreak(PreviousNode->State))
       return;
     if (!NewLine && Indenter->mustBreak(PreviousNode->State))
       return;
 
-    StateNode *Node = new (Allocator.Allocate())
-        StateNode(PreviousNode->State, NewLine, PreviousNode);
-    if (!formatChildren(Node->State, NewLine, /*DryRun=*/true, Penalty))
+    // Only allocate the node once it is known to be new, so that the pruned
+    // states do not use up memory.
+    StateNode Next(PreviousNode->State, NewLine, PreviousNode);
+    if (!formatChildren(Next.State, NewLine, /*DryRun=*/true, Penalty))
       return;
 
-    Penalty += Indenter->addTokenToState(Node->State, NewLine, true);
+    Penalty += Indenter->addTokenToState(Next.State, NewLine, true);
 
-    Queue->push(QueueItem(OrderedPenalty(Penalty, *Count), Node));
+    if (!Seen || !Seen->count(&Next.State)) {
+      StateNode *Node = new (Allocator.Allocate()) StateNode(std::move(Next));
+      Queue->push(QueueItem(OrderedPenalty(Penalty, *Count), Node));
+    }
     ++(*Count);
   }
 
@@ -883,14 +942,131 @@ private:
   llvm::SpecificBumpPtrAllocator<StateNode> Allocator;
 };
 
+bool isTouched(const AnnotatedLine &Line) {
+  return Line.Affected || Line.ChildrenAffected ||
+         Line.LeadingEmptyLinesAffected;
+}
+
+bool isTopLevel(const AnnotatedLine &Line) {
+  return Line.Level == 0 && !Line.InPPDirective;
+}
+
+bool isCommentLine(const AnnotatedLine &Line) {
+  for (const FormatToken *Tok = Line.First; Tok; Tok = Tok->Next)
+    if (Tok->isNot(tok::comment))
+      return false;
+  return true;
+}
+
+bool containsComment(const AnnotatedLine &Line) {
+  for (const FormatToken *Tok = Line.First; Tok; Tok = Tok->Next)
+    if (Tok->is(tok::comment))
+      return true;
+  return false;
+}
+
+/// \brief Returns true if formatting can start at \p Lines[I] when none of
+/// the lines before it is affected.
+///
+/// This is the case if the line starts a group of joined lines, and if the
+/// sequences of aligned tokens and trailing comments cannot extend across it,
+/// as \c LineJoiner and \c WhitespaceManager then treat the following lines
+/// the same way whether the previous lines are formatted or not.
+bool canStartFormattingAt(const SmallVectorImpl<AnnotatedLine *> &Lines,
+                          unsigned I) {
+  const AnnotatedLine &Line = *Lines[I];
+  if (!isTopLevel(Line) || Line.First->NewlinesBefore == 0 ||
+      Line.First->isOneOf(tok::l_brace, tok::r_brace, tok::equal,
+                          TT_StartOfName, TT_FunctionDeclarationName) ||
+      containsComment(Line))
+    return false;
+
+  // Skip the line comments documenting the line; they cannot be joined with
+  // anything.
+  while (I > 0 && isTopLevel(*Lines[I - 1]) && isCommentLine(*Lines[I - 1]) &&
+         Lines[I - 1]->Last->is(TT_LineComment) &&
+         Lines[I - 1]->First->NewlinesBefore > 0)
+    --I;
+
+  // The previous declaration or statement must be complete and separated by
+  // an empty line.
+  if (I == 0 || Lines[I]->First->NewlinesBefore < 2)
+    return false;
+  const AnnotatedLine &Previous = *Lines[I - 1];
+  return isTopLevel(Previous) &&
+         Previous.Last->isOneOf(tok::semi, tok::r_brace) &&
+         !Previous.First->isOneOf(tok::kw_if, tok::kw_for, tok::kw_while,
+                                  tok::kw_case, tok::kw_default) &&
+         (I < 2 ||
+          !Lines[I - 2]->First->isOneOf(tok::kw_case, tok::kw_default));
+}
+
+/// \brief Returns true if formatting can stop before \p Lines[I] when neither
+/// the previous line nor any of the following lines is affected.
+///
+/// This is the case if the previous line closes a top-level block and cannot
+/// be joined with the lines around it: it then stops the reindentation of the
+/// lines following the affected ones, and the empty line after it ends the
+/// sequences of aligned tokens and trailing comments.
+bool canStopFormattingAt(const SmallVectorImpl<AnnotatedLine *> &Lines,
+                         unsigned I) {
+  if (I < 3 || Lines[I]->First->NewlinesBefore < 2 ||
+      Lines[I]->First->is(tok::l_brace))
+    return false;
+  const AnnotatedLine &Previous = *Lines[I - 1];
+  if (!isTopLevel(Previous) || Previous.First->isNot(tok::r_brace) ||
+      !Previous.Last->isOneOf(tok::semi, tok::r_brace))
+    return false;
+
+  // A closing brace is only joined with an empty or single line block.
+  const AnnotatedLine &Body = *Lines[I - 2];
+  const AnnotatedLine &BeforeBody = *Lines[I - 3];
+  return !Body.InPPDirective && Body.First->isNot(tok::l_brace) &&
+         Body.Last->isOneOf(tok::semi, tok::r_brace) &&
+         BeforeBody.First->isNot(tok::l_brace) &&
+         BeforeBody.Last->isNot(tok::l_brace);
+}
+
 } // anonymous namespace
 
+std::pair<unsigned, unsigned> UnwrappedLineFormatter::getFormattingRange(
+    const SmallVectorImpl<AnnotatedLine *> &Lines, const FormatStyle &Style) {
+  unsigned FirstTouched = Lines.size();
+  unsigned LastTouched = 0;
+  for (unsigned i = 0, e = Lines.size(); i != e; ++i) {
+    if (isTouched(*Lines[i])) {
+      FirstTouched = std::min(FirstTouched, i);
+      LastTouched = i;
+    }
+  }
+  if (FirstTouched == Lines.size())
+    return std::make_pair(0u, 0u);
+
+  // Compacted namespaces join an unbounded number of lines.
+  if (Style.CompactNamespaces)
+    return std::make_pair(0u, static_cast<unsigned>(Lines.size()));
+
+  unsigned Begin = FirstTouched;
+  while (Begin > 0 &&
+         (Begin == FirstTouched || !canStartFormattingAt(Lines, Begin)))
+    --Begin;
+  unsigned End = LastTouched + 2;
+  while (End < Lines.size() && !canStopFormattingAt(Lines, End))
+    ++End;
+  return std::make_pair(Begin, std::min<unsigned>(End, Lines.size()));
+}
+
+void UnwrappedLineFormatter::formatRange(
+    const SmallVectorImpl<AnnotatedLine *> &Lines, unsigned Begin,
+    unsigned End) {
+  formatLines(Lines, Begin, End, /*DryRun=*/false, /*AdditionalIndent=*/0,
+              /*FixBadIndentation=*/false);
+}
+
 unsigned
 UnwrappedLineFormatter::format(const SmallVectorImpl<AnnotatedLine *> &Lines,
                                bool DryRun, int AdditionalIndent,
                                bool FixBadIndentation) {
-  LineJoiner Joiner(Style, Keywords, Lines);
-
   // Try to look up already computed penalty in DryRun-mode.
   std::pair<const SmallVectorImpl<AnnotatedLine *> *, unsigned> CacheKey(
       &Lines, AdditionalIndent);
@@ -898,9 +1074,20 @@ UnwrappedLineFormatter::format(const SmallVectorImpl<AnnotatedLine *> &Lines,
   if (DryRun && CacheIt != PenaltyCache.end())
     return CacheIt->second;
 
-  assert(!Lines.empty());
+  unsigned Penalty = formatLines(Lines, 0, Lines.size(), DryRun,
+                                 AdditionalIndent, FixBadIndentation);
+  PenaltyCache[CacheKey] = Penalty;
+  return Penalty;
+}
+
+unsigned UnwrappedLineFormatter::formatLines(
+    const SmallVectorImpl<AnnotatedLine *> &Lines, unsigned Begin,
+    unsigned End, bool DryRun, int AdditionalIndent, bool FixBadIndentation) {
+  LineJoiner Joiner(Style, Keywords, Lines, Begin, End);
+
+  assert(Begin < End && End <= Lines.size());
   unsigned Penalty = 0;
-  LevelIndentTracker IndentTracker(Style, Keywords, Lines[0]->Level,
+  LevelIndentTracker IndentTracker(Style, Keywords, Lines[Begin]->Level,
                                    AdditionalIndent);
   const AnnotatedLine *PreviousLine = nullptr;
   const AnnotatedLine *NextLine = nullptr;
@@ -992,7 +1179,6 @@ UnwrappedLineFormatter::format(const SmallVectorImpl<AnnotatedLine *> &Lines,
       markFinalized(TheLine.First);
     PreviousLine = &TheLine;
   }
-  PenaltyCache[CacheKey] = Penalty;
   return Penalty;
 }
 
@@ -43,7 +43,30 @@ public:
                   bool DryRun = false, int AdditionalIndent = 0,
                   bool FixBadIndentation = false);
 
+  /// \brief Format the lines [\p Begin, \p End) of the top-level \p Lines.
+  ///
+  /// The range must be computed by \c getFormattingRange, so that the lines
+  /// outside of it are left as they would be by formatting all of \p Lines.
+  void formatRange(const SmallVectorImpl<AnnotatedLine *> &Lines,
+                   unsigned Begin, unsigned End);
+
+  /// \brief Returns the range [Begin, End) of the top-level \p Lines that
+  /// formatting their affected lines can change.
+  ///
+  /// The range is bounded by top-level declarations that can neither be joined
+  /// nor aligned with the lines around them, so only the lines in the range
+  /// need formatting information. The range is empty if no line is affected.
+  static std::pair<unsigned, unsigned>
+  getFormattingRange(const SmallVectorImpl<AnnotatedLine *> &Lines,
+                     const FormatStyle &Style);
+
 private:
+  /// \brief Format the lines [\p Begin, \p End) of the current block and
+  /// return the penalty.
+  unsigned formatLines(const SmallVectorImpl<AnnotatedLine *> &Lines,
+                       unsigned Begin, unsigned End, bool DryRun,
+                       int AdditionalIndent, bool FixBadIndentation);
+
   /// \brief Add a new line and the required indent before the first Token
   /// of the \c UnwrappedLine if there was no structural parsing error.
   void formatFirstToken(const AnnotatedLine &Line,
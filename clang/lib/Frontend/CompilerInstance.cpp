@@ -28,6 +28,7 @@
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Frontend/VerifyDiagnosticConsumer.h"
+#include "clang/Lex/HeaderLookupCache.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
@@ -378,6 +379,17 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
   HeaderSearch *HeaderInfo =
       new HeaderSearch(getHeaderSearchOptsPtr(), getSourceManager(),
                        getDiagnostics(), getLangOpts(), &getTarget());
+
+  // The header lookup cache lists the directories of the real file system, so
+  // it cannot be used when some files only exist virtually.
+  const HeaderSearchOptions &HSOpts = getHeaderSearchOpts();
+  if (!HSOpts.LookupCachePath.empty() && PPOpts.RemappedFiles.empty() &&
+      PPOpts.RemappedFileBuffers.empty() &&
+      getFileManager().getVirtualFileSystem() == vfs::getRealFileSystem())
+    HeaderInfo->setLookupCache(
+        llvm::make_unique<HeaderLookupCache>(HSOpts.LookupCachePath,
+                                             getFileManager()));
+
   PP = std::make_shared<Preprocessor>(
       Invocation->getPreprocessorOptsPtr(), getDiagnostics(), getLangOpts(),
       getSourceManager(), getPCMCache(), *HeaderInfo, *this, PTHMgr,
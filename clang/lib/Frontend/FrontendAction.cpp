@@ -18,6 +18,7 @@
 #include "clang/Frontend/LayoutOverrideSource.h"
 #include "clang/Frontend/MultiplexConsumer.h"
 #include "clang/Frontend/Utils.h"
+#include "clang/Lex/HeaderLookupCache.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/LiteralSupport.h"
 #include "clang/Lex/Preprocessor.h"
@@ -922,9 +923,16 @@ void FrontendAction::EndSourceFile() {
   CI.getDiagnosticClient().EndSourceFile();
 
   // Inform the preprocessor we are done.
-  if (CI.hasPreprocessor())
+  if (CI.hasPreprocessor()) {
     CI.getPreprocessor().EndSourceFile();
 
+    // Persist the directories listed by header search for the next
+    // compilations.
+    if (HeaderLookupCache *Cache =
+            CI.getPreprocessor().getHeaderSearchInfo().getLookupCache())
+      Cache->write();
+  }
+
   // Finalize the action.
   EndSourceFileAction();
 
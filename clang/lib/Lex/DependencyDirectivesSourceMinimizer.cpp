@@ -0,0 +1,444 @@
+//===- DependencyDirectivesSourceMinimizer.cpp - Minimize source ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file implements the minimization of a source file down to the
+/// preprocessor directives that can affect its dependencies.
+///
+/// The minimizer does not lex the input into tokens. It only knows enough
+/// about comments, string and character literals and escaped newlines to find
+/// the lines that start with a directive.
+///
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "clang/Basic/CharInfo.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSwitch.h"
+
+using namespace clang;
+
+namespace {
+
+/// \brief How a directive is treated by the minimizer.
+enum DirectiveKind {
+  /// The directive is dropped.
+  DK_Drop,
+  /// The directive is kept verbatim.
+  DK_Keep,
+  /// The directive is kept and its operand may be a <header-name>.
+  DK_Include,
+  /// The directive is only kept for some pragmas.
+  DK_Pragma
+};
+
+class Minimizer {
+public:
+  Minimizer(StringRef Input, SmallVectorImpl<char> &Out)
+      : Input(Input), Out(Out), Error(false) {}
+
+  /// \returns true on error.
+  bool minimize();
+
+private:
+  void skipLine(const char *&First, const char *const End);
+  void skipHorizontalSpace(const char *&First, const char *const End);
+  void skipBlockComment(const char *&First, const char *const End);
+  void skipString(const char *&First, const char *const End);
+  void skipRawString(const char *&First, const char *const End);
+
+  void lexDirective(const char *&First, const char *const End);
+  void lexPragma(const char *&First, const char *const End);
+  void printRestOfLine(const char *&First, const char *const End,
+                       bool IsInclude);
+  void printQuoted(const char *&First, const char *const End);
+
+  bool isRawStringLiteralStart(const char *Quote) const;
+  bool isDigitSeparator(const char *Quote) const;
+
+  StringRef Input;
+  SmallVectorImpl<char> &Out;
+  bool Error;
+};
+
+} // end anonymous namespace
+
+/// \brief Skips the newline at \p First, which may be a two character one.
+static const char *skipNewline(const char *First, const char *const End) {
+  assert(isVerticalWhitespace(*First));
+  char C = *First++;
+  if (First != End && isVerticalWhitespace(*First) && *First != C)
+    ++First;
+  return First;
+}
+
+/// \brief If the backslash at \p First escapes a newline, returns a pointer
+/// past that newline, otherwise returns null.
+static const char *skipEscapedNewline(const char *First,
+                                      const char *const End) {
+  assert(*First == '\\');
+  const char *Cur = First + 1;
+  while (Cur != End && isHorizontalWhitespace(*Cur))
+    ++Cur;
+  if (Cur == End || !isVerticalWhitespace(*Cur))
+    return nullptr;
+  return skipNewline(Cur, End);
+}
+
+/// \brief Skips a // comment, leaving \p First at the newline that ends it.
+static void skipLineComment(const char *&First, const char *const End) {
+  assert(First[0] == '/' && First[1] == '/');
+  First += 2;
+  while (First != End && !isVerticalWhitespace(*First)) {
+    if (*First == '\\')
+      if (const char *Next = skipEscapedNewline(First, End)) {
+        First = Next;
+        continue;
+      }
+    ++First;
+  }
+}
+
+static bool startsBlockComment(const char *First, const char *const End) {
+  return First + 1 < End && First[0] == '/' && First[1] == '*';
+}
+
+static bool startsLineComment(const char *First, const char *const End) {
+  return First + 1 < End && First[0] == '/' && First[1] == '/';
+}
+
+void Minimizer::skipBlockComment(const char *&First, const char *const End) {
+  assert(startsBlockComment(First, End));
+  for (First += 2; First + 1 < End; ++First)
+    if (First[0] == '*' && First[1] == '/') {
+      First += 2;
+      return;
+    }
+  // An unterminated block comment swallows the rest of the file.
+  First = End;
+  Error = true;
+}
+
+/// \brief Skips a string or character literal, leaving \p First after the
+/// closing quote or at the newline that ends an unterminated literal.
+void Minimizer::skipString(const char *&First, const char *const End) {
+  const char Quote = *First++;
+  while (First != End && *First != Quote && !isVerticalWhitespace(*First)) {
+    // Skip the escaped character, which may be an escaped newline.
+    if (*First == '\\') {
+      if (const char *Next = skipEscapedNewline(First, End)) {
+        First = Next;
+        continue;
+      }
+      if (++First == End)
+        return;
+    }
+    ++First;
+  }
+  if (First != End && *First == Quote)
+    ++First;
+}
+
+void Minimizer::skipRawString(const char *&First, const char *const End) {
+  assert(*First == '"');
+  const char *DelimStart = First + 1;
+  const char *DelimEnd = DelimStart;
+  while (DelimEnd != End && DelimEnd - DelimStart <= 16 && *DelimEnd != '(' &&
+         *DelimEnd != ')' && *DelimEnd != '\\' && !isWhitespace(*DelimEnd))
+    ++DelimEnd;
+  if (DelimEnd == End || *DelimEnd != '(') {
+    // Not a valid raw string literal, the lexer will diagnose it.
+    skipString(First, End);
+    return;
+  }
+
+  StringRef Delim(DelimStart, DelimEnd - DelimStart);
+  for (First = DelimEnd + 1; First != End; ++First) {
+    if (*First != ')')
+      continue;
+    StringRef Rest(First + 1, End - First - 1);
+    if (Rest.startswith(Delim) && Rest.substr(Delim.size()).startswith("\"")) {
+      First += Delim.size() + 2;
+      return;
+    }
+  }
+  Error = true;
+}
+
+/// \brief Returns true if the '"' at \p Quote starts a raw string literal,
+/// i.e. it is preceded by an 'R' with an optional encoding prefix.
+bool Minimizer::isRawStringLiteralStart(const char *Quote) const {
+  const char *BufferStart = Input.begin();
+  if (Quote == BufferStart || Quote[-1] != 'R')
+    return false;
+  const char *Prefix = Quote - 1;
+  if (Prefix - BufferStart >= 2 && Prefix[-2] == 'u' && Prefix[-1] == '8')
+    Prefix -= 2;
+  else if (Prefix != BufferStart &&
+           (Prefix[-1] == 'u' || Prefix[-1] == 'U' || Prefix[-1] == 'L'))
+    --Prefix;
+  return Prefix == BufferStart || !isIdentifierBody(Prefix[-1]);
+}
+
+/// \brief Returns true if the '\'' at \p Quote is a digit separator inside a
+/// pp-number, e.g. 1'000, rather than the start of a character literal.
+bool Minimizer::isDigitSeparator(const char *Quote) const {
+  const char *BufferStart = Input.begin();
+  if (Quote == BufferStart || !isAlphanumeric(Quote[-1]))
+    return false;
+  const char *Start = Quote;
+  while (Start != BufferStart &&
+         (isIdentifierBody(Start[-1]) || Start[-1] == '\'' || Start[-1] == '.'))
+    --Start;
+  return isDigit(*Start) || (*Start == '.' && isDigit(Start[1]));
+}
+
+/// \brief Skips the rest of the logical line, including the newline.
+void Minimizer::skipLine(const char *&First, const char *const End) {
+  while (First != End) {
+    const char C = *First;
+    if (isVerticalWhitespace(C)) {
+      First = skipNewline(First, End);
+      return;
+    }
+    if (C == '\\') {
+      if (const char *Next = skipEscapedNewline(First, End))
+        First = Next;
+      else
+        ++First;
+      continue;
+    }
+    if (startsBlockComment(First, End)) {
+      skipBlockComment(First, End);
+      continue;
+    }
+    if (startsLineComment(First, End)) {
+      skipLineComment(First, End);
+      continue;
+    }
+    if (C == '"') {
+      if (isRawStringLiteralStart(First))
+        skipRawString(First, End);
+      else
+        skipString(First, End);
+      continue;
+    }
+    if (C == '\'' && !isDigitSeparator(First)) {
+      skipString(First, End);
+      continue;
+    }
+    ++First;
+  }
+}
+
+/// \brief Skips horizontal whitespace, block comments and escaped newlines.
+void Minimizer::skipHorizontalSpace(const char *&First,
+                                    const char *const End) {
+  while (First != End) {
+    if (isHorizontalWhitespace(*First)) {
+      ++First;
+    } else if (startsBlockComment(First, End)) {
+      skipBlockComment(First, End);
+    } else if (*First == '\\') {
+      const char *Next = skipEscapedNewline(First, End);
+      if (!Next)
+        return;
+      First = Next;
+    } else {
+      return;
+    }
+  }
+}
+
+/// \brief Copies a string or character literal to the output.
+void Minimizer::printQuoted(const char *&First, const char *const End) {
+  const char *Start = First;
+  skipString(First, End);
+  // Drop escaped newlines, which skipString() steps over.
+  for (const char *Cur = Start; Cur != First; ++Cur) {
+    if (*Cur == '\\')
+      if (const char *Next = skipEscapedNewline(Cur, End)) {
+        Cur = Next - 1;
+        continue;
+      }
+    Out.push_back(*Cur);
+  }
+}
+
+/// \brief Copies the rest of the logical line to the output, dropping the
+/// comments and escaped newlines and collapsing horizontal whitespace, and
+/// terminates it with a newline.
+void Minimizer::printRestOfLine(const char *&First, const char *const End,
+                                bool IsInclude) {
+  skipHorizontalSpace(First, End);
+  if (First != End && !isVerticalWhitespace(*First))
+    Out.push_back(' ');
+
+  if (IsInclude && First != End && *First == '<') {
+    // A <header-name> may contain characters that would otherwise start a
+    // comment or a literal.
+    while (First != End && !isVerticalWhitespace(*First)) {
+      Out.push_back(*First);
+      if (*First++ == '>')
+        break;
+    }
+  }
+
+  while (First != End && !isVerticalWhitespace(*First)) {
+    if (isHorizontalWhitespace(*First) || startsBlockComment(First, End) ||
+        *First == '\\') {
+      const char *Start = First;
+      skipHorizontalSpace(First, End);
+      if (First == Start) {
+        // A stray backslash.
+        Out.push_back(*First++);
+        continue;
+      }
+      if (Out.back() != ' ')
+        Out.push_back(' ');
+      continue;
+    }
+    if (startsLineComment(First, End)) {
+      skipLineComment(First, End);
+      continue;
+    }
+    if (*First == '"' || (*First == '\'' && !isDigitSeparator(First))) {
+      printQuoted(First, End);
+      continue;
+    }
+    Out.push_back(*First++);
+  }
+
+  while (Out.back() == ' ')
+    Out.pop_back();
+  Out.push_back('\n');
+  if (First != End)
+    First = skipNewline(First, End);
+}
+
+/// \brief Lexes an identifier, which may be split by escaped newlines; the
+/// spliced spelling is built in \p Storage in that case.
+static StringRef lexIdentifier(const char *&First, const char *const End,
+                               SmallVectorImpl<char> &Storage) {
+  const char *Start = First;
+  while (First != End && isIdentifierBody(*First))
+    ++First;
+  if (First == End || *First != '\\')
+    return StringRef(Start, First - Start);
+
+  Storage.assign(Start, First);
+  while (First != End) {
+    if (isIdentifierBody(*First)) {
+      Storage.push_back(*First++);
+      continue;
+    }
+    const char *Next = *First == '\\' ? skipEscapedNewline(First, End)
+                                       : nullptr;
+    if (!Next)
+      break;
+    First = Next;
+  }
+  return StringRef(Storage.data(), Storage.size());
+}
+
+void Minimizer::lexPragma(const char *&First, const char *const End) {
+  skipHorizontalSpace(First, End);
+  const char *PragmaStart = First;
+  SmallString<32> NameStorage, SubNameStorage;
+  StringRef Name = lexIdentifier(First, End, NameStorage);
+  bool Keep = llvm::StringSwitch<bool>(Name)
+                  .Cases("once", "push_macro", "pop_macro", "include_alias",
+                         true)
+                  .Default(false);
+  if (Name == "GCC" || Name == "clang") {
+    skipHorizontalSpace(First, End);
+    StringRef SubName = lexIdentifier(First, End, SubNameStorage);
+    Keep = SubName == "system_header" ||
+           (Name == "clang" && SubName == "module");
+  }
+  if (!Keep) {
+    skipLine(First, End);
+    return;
+  }
+
+  StringRef Pragma = "#pragma";
+  Out.append(Pragma.begin(), Pragma.end());
+  First = PragmaStart;
+  printRestOfLine(First, End, /*IsInclude=*/false);
+}
+
+void Minimizer::lexDirective(const char *&First, const char *const End) {
+  skipHorizontalSpace(First, End);
+  SmallString<32> NameStorage;
+  StringRef Name = lexIdentifier(First, End, NameStorage);
+  DirectiveKind Kind = llvm::StringSwitch<DirectiveKind>(Name)
+                           .Cases("include", "include_next", "import",
+                                  "__include_macros", DK_Include)
+                           .Cases("define", "undef", DK_Keep)
+                           .Cases("if", "ifdef", "ifndef", "elif", DK_Keep)
+                           .Cases("else", "endif", DK_Keep)
+                           .Case("pragma", DK_Pragma)
+                           .Default(DK_Drop);
+  switch (Kind) {
+  case DK_Drop:
+    skipLine(First, End);
+    return;
+  case DK_Pragma:
+    lexPragma(First, End);
+    return;
+  case DK_Keep:
+  case DK_Include:
+    Out.push_back('#');
+    Out.append(Name.begin(), Name.end());
+    printRestOfLine(First, End, Kind == DK_Include);
+    return;
+  }
+  llvm_unreachable("unknown directive kind");
+}
+
+bool Minimizer::minimize() {
+  const char *First = Input.begin();
+  const char *const End = Input.end();
+
+  // Skip a UTF-8 byte order mark.
+  if (Input.startswith("\xEF\xBB\xBF"))
+    First += 3;
+
+  while (First != End && !Error) {
+    // Whitespace and comments may precede a directive on its line.
+    skipHorizontalSpace(First, End);
+    if (First == End)
+      break;
+
+    StringRef Rest(First, End - First);
+    if (Rest.startswith("#")) {
+      ++First;
+      lexDirective(First, End);
+    } else if (Rest.startswith("%:")) {
+      // A digraph for '#'.
+      First += 2;
+      lexDirective(First, End);
+    } else if (Rest.startswith("@import") &&
+               (Rest.size() == 7 || !isIdentifierBody(Rest[7]))) {
+      StringRef Import = "@import";
+      Out.append(Import.begin(), Import.end());
+      First += Import.size();
+      printRestOfLine(First, End, /*IsInclude=*/false);
+    } else {
+      skipLine(First, End);
+    }
+  }
+  return Error;
+}
+
+bool clang::minimizeSourceToDependencyDirectives(
+    StringRef Input, SmallVectorImpl<char> &Output) {
+  Output.clear();
+  return Minimizer(Input, Output).minimize();
+}
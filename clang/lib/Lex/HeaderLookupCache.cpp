@@ -0,0 +1,347 @@
+//===--- HeaderLookupCache.cpp - Persistent header lookup cache -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the HeaderLookupCache class.
+//
+//  The cache file starts with a small header (magic, version, offset of the
+//  hash table and time the file was written) followed by an on-disk hash
+//  table mapping the absolute real path of each directory to its
+//  modification time and the lowercased names of its entries, each
+//  terminated by a NUL character.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/HeaderLookupCache.h"
+#include "clang/Basic/CharInfo.h"
+#include "clang/Basic/FileManager.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <cstdio>
+
+using namespace clang;
+
+static const char CacheMagic[4] = {'C', 'H', 'L', 'C'};
+static const uint32_t CacheVersion = 2;
+static const unsigned CacheHeaderSize = 20;
+
+/// Listings of directories modified less than this long before they were
+/// read are not persisted: a later modification may not change the
+/// modification time on file systems with a coarse timestamp granularity.
+static const std::chrono::seconds RacyListingAge(2);
+
+/// Returns the number of whole seconds in a time stored in the cache.
+static uint64_t toSeconds(uint64_t Time) {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             llvm::sys::TimePoint<>::duration(Time))
+      .count();
+}
+
+namespace clang {
+
+class HeaderLookupCacheTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  /// The modification time of the directory and its NUL-terminated names.
+  typedef std::pair<uint64_t, StringRef> data_type;
+  typedef const data_type &data_type_ref;
+  typedef uint32_t hash_value_type;
+  typedef uint32_t offset_type;
+
+  static hash_value_type ComputeHash(StringRef Key) {
+    return llvm::HashString(Key);
+  }
+
+  static bool EqualKey(StringRef A, StringRef B) { return A == B; }
+
+  static StringRef GetInternalKey(StringRef Key) { return Key; }
+  static StringRef GetExternalKey(StringRef Key) { return Key; }
+
+  static std::pair<offset_type, offset_type>
+  EmitKeyDataLength(raw_ostream &Out, StringRef Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    offset_type KeyLen = Key.size();
+    offset_type DataLen = sizeof(uint64_t) + Data.second.size();
+    LE.write<offset_type>(KeyLen);
+    LE.write<offset_type>(DataLen);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static void EmitKey(raw_ostream &Out, StringRef Key, offset_type) {
+    Out << Key;
+  }
+
+  static void EmitData(raw_ostream &Out, StringRef, data_type_ref Data,
+                       offset_type) {
+    using namespace llvm::support;
+    endian::Writer<little>(Out).write<uint64_t>(Data.first);
+    Out << Data.second;
+  }
+
+  static std::pair<offset_type, offset_type>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    offset_type KeyLen = endian::readNext<offset_type, little, unaligned>(D);
+    offset_type DataLen = endian::readNext<offset_type, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static StringRef ReadKey(const unsigned char *D, offset_type KeyLen) {
+    return StringRef(reinterpret_cast<const char *>(D), KeyLen);
+  }
+
+  static data_type ReadData(StringRef, const unsigned char *D,
+                            offset_type DataLen) {
+    using namespace llvm::support;
+    uint64_t ModTime = endian::readNext<uint64_t, little, unaligned>(D);
+    return data_type(ModTime,
+                     StringRef(reinterpret_cast<const char *>(D),
+                               DataLen - sizeof(uint64_t)));
+  }
+};
+
+} // end namespace clang
+
+HeaderLookupCache::HeaderLookupCache(StringRef Path, FileManager &FileMgr)
+    : Path(Path), FileMgr(FileMgr), Saver(Alloc) {
+  auto BufferOrErr = llvm::MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                                                 /*RequiresNullTerminator=*/
+                                                 false);
+  if (!BufferOrErr)
+    return;
+
+  // Validate the header; a cache file we cannot make sense of is ignored,
+  // and replaced on the next write.
+  StringRef Data = (*BufferOrErr)->getBuffer();
+  if (Data.size() < CacheHeaderSize ||
+      !Data.startswith(StringRef(CacheMagic, sizeof(CacheMagic))))
+    return;
+  using namespace llvm::support;
+  const unsigned char *Ptr =
+      reinterpret_cast<const unsigned char *>(Data.data()) + sizeof(CacheMagic);
+  uint32_t Version = endian::readNext<uint32_t, little, unaligned>(Ptr);
+  uint32_t TableOffset = endian::readNext<uint32_t, little, unaligned>(Ptr);
+  uint64_t FileWriteTime = endian::readNext<uint64_t, little, unaligned>(Ptr);
+  if (Version != CacheVersion || TableOffset % 4 != 0 ||
+      TableOffset < CacheHeaderSize ||
+      uint64_t(TableOffset) + 2 * sizeof(uint32_t) > Data.size())
+    return;
+  const unsigned char *Base =
+      reinterpret_cast<const unsigned char *>(Data.data());
+  const unsigned char *Buckets = Base + TableOffset;
+  uint32_t NumBuckets = endian::read<uint32_t, little, aligned>(Buckets);
+  if (uint64_t(TableOffset) + (2 + uint64_t(NumBuckets)) * sizeof(uint32_t) >
+      Data.size())
+    return;
+
+  WriteTime = FileWriteTime;
+  Buffer = std::move(*BufferOrErr);
+  Table.reset(OnDiskTable::Create(Buckets, Base + CacheHeaderSize, Base));
+}
+
+HeaderLookupCache::~HeaderLookupCache() {}
+
+const HeaderLookupCache::DirectoryListing &
+HeaderLookupCache::getListing(StringRef Dir) {
+  auto Insertion = Listings.try_emplace(Dir);
+  DirectoryListing &Listing = Insertion.first->second;
+  if (!Insertion.second)
+    return Listing;
+
+  llvm::sys::fs::file_status Status;
+  if (llvm::sys::fs::status(Dir, Status) ||
+      Status.type() != llvm::sys::fs::file_type::directory_file)
+    return Listing;
+  auto ModTime = Status.getLastModificationTime();
+  Listing.ModTime = ModTime.time_since_epoch().count();
+
+  // Reuse the listing recorded on disk if the directory did not change. A
+  // directory modified in the second the cache was written may have changed
+  // after it was listed without its modification time showing it.
+  if (Table && toSeconds(Listing.ModTime) < toSeconds(WriteTime)) {
+    auto It = Table->find(Dir);
+    if (It != Table->end() && (*It).first == Listing.ModTime) {
+      SmallVector<StringRef, 64> Names;
+      (*It).second.split(Names, '\0', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+      Listing.Names.insert(Names.begin(), Names.end());
+      Listing.Known = true;
+      ++NumListingsReused;
+      return Listing;
+    }
+  }
+
+  std::error_code EC;
+  SmallString<64> Name;
+  for (llvm::sys::fs::directory_iterator I(Dir, EC), E; I != E && !EC;
+       I.increment(EC)) {
+    Name = llvm::sys::path::filename(I->path());
+    for (char &C : Name)
+      C = toLowercase(C);
+    Listing.Names.insert(Saver.save(Name.str()));
+  }
+  if (EC) {
+    Listing.Names.clear();
+    return Listing;
+  }
+  Listing.Known = true;
+  Listing.IsNew = std::chrono::system_clock::now() - ModTime >= RacyListingAge;
+  ++NumListingsRead;
+  return Listing;
+}
+
+StringRef HeaderLookupCache::getCanonicalDir(const DirectoryEntry *Dir) {
+  auto Known = CanonicalDirs.find(Dir);
+  if (Known != CanonicalDirs.end())
+    return Known->second;
+
+  // The spelling of a directory may be relative to the working directory of
+  // this compilation, which the cache file outlives.
+  SmallString<256> AbsPath(Dir->getName());
+  FileMgr.makeAbsolutePath(AbsPath);
+  SmallString<256> RealPath;
+  StringRef Canonical;
+  if (!llvm::sys::fs::real_path(AbsPath, RealPath))
+    Canonical = Saver.save(RealPath.str());
+  CanonicalDirs[Dir] = Canonical;
+  return Canonical;
+}
+
+bool HeaderLookupCache::mayContainFile(const DirectoryEntry *Dir,
+                                       StringRef Filename) {
+  ++NumLookups;
+  if (llvm::sys::path::is_absolute(Filename))
+    return true;
+
+  StringRef CanonicalDir = getCanonicalDir(Dir);
+  if (CanonicalDir.empty())
+    return true;
+
+  SmallString<256> DirPath(CanonicalDir);
+  SmallString<64> LowerComponent;
+  for (auto I = llvm::sys::path::begin(Filename),
+            E = llvm::sys::path::end(Filename);
+       I != E; ++I) {
+    StringRef Component = *I;
+    if (Component == "." || Component == "..")
+      return true;
+
+    // Only ASCII names are folded; leave the others to the file system, which
+    // may fold them in its own way.
+    LowerComponent.clear();
+    for (char C : Component) {
+      if (!isASCII(C))
+        return true;
+      LowerComponent.push_back(toLowercase(C));
+    }
+
+    const DirectoryListing &Listing = getListing(DirPath);
+    if (!Listing.Known)
+      return true;
+    if (!Listing.Names.count(LowerComponent)) {
+      ++NumRejectedLookups;
+      return false;
+    }
+    llvm::sys::path::append(DirPath, Component);
+  }
+  return true;
+}
+
+void HeaderLookupCache::write() {
+  bool HasNewListings = false;
+  for (const auto &Entry : Listings)
+    HasNewListings |= Entry.second.IsNew;
+  if (!HasNewListings)
+    return;
+
+  llvm::OnDiskChainedHashTableGenerator<HeaderLookupCacheTrait> Generator;
+  // The names of the new listings, NUL-terminated; the generator only keeps
+  // references to them.
+  std::vector<std::string> NewNames;
+  NewNames.reserve(Listings.size());
+  for (const auto &Entry : Listings) {
+    const DirectoryListing &Listing = Entry.second;
+    if (!Listing.IsNew)
+      continue;
+    NewNames.emplace_back();
+    std::string &Names = NewNames.back();
+    for (StringRef Name : Listing.Names) {
+      Names += Name;
+      Names += '\0';
+    }
+    Generator.insert(Entry.first(),
+                     HeaderLookupCacheTrait::data_type(Listing.ModTime, Names));
+  }
+
+  // Keep the listings of the other compilations that share this cache.
+  if (Table) {
+    for (auto I = Table->key_begin(), E = Table->key_end(); I != E; ++I) {
+      StringRef Dir = *I;
+      auto Known = Listings.find(Dir);
+      if (Known != Listings.end() && Known->second.IsNew)
+        continue;
+      // Drop the listings that could not be trusted with the old write time;
+      // they would be trusted with the new one.
+      HeaderLookupCacheTrait::data_type Data = *Table->find(Dir);
+      if (toSeconds(Data.first) >= toSeconds(WriteTime))
+        continue;
+      Generator.insert(Dir, Data);
+    }
+  }
+
+  llvm::sys::TimePoint<> Now = std::chrono::system_clock::now();
+  SmallString<4096> Contents;
+  {
+    llvm::raw_svector_ostream Out(Contents);
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    Out.write(CacheMagic, sizeof(CacheMagic));
+    LE.write<uint32_t>(CacheVersion);
+    LE.write<uint32_t>(0); // Patched below.
+    LE.write<uint64_t>(Now.time_since_epoch().count());
+    uint32_t TableOffset = Generator.Emit(Out);
+    endian::write<uint32_t, little, unaligned>(
+        Contents.data() + sizeof(CacheMagic) + sizeof(uint32_t), TableOffset);
+  }
+
+  // Write to a temporary file and rename it over the cache, so that a
+  // concurrent compilation never reads a partially written cache.
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out << Contents;
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
+
+void HeaderLookupCache::PrintStats() const {
+  fprintf(stderr, "%u header lookup cache queries, %u rejected.\n",
+          NumLookups, NumRejectedLookups);
+  fprintf(stderr, "  %u directory listings read, %u reused.\n",
+          NumListingsRead, NumListingsReused);
+}
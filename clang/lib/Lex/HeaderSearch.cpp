@@ -15,6 +15,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Lex/ExternalPreprocessorSource.h"
+#include "clang/Lex/HeaderLookupCache.h"
 #include "clang/Lex/HeaderMap.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/LexDiagnostic.h"
@@ -78,6 +79,10 @@ HeaderSearch::~HeaderSearch() {
     delete HeaderMaps[i].second;
 }
 
+void HeaderSearch::setLookupCache(std::unique_ptr<HeaderLookupCache> Cache) {
+  LookupCache = std::move(Cache);
+}
+
 void HeaderSearch::PrintStats() {
   fprintf(stderr, "\n*** HeaderSearch Stats:\n");
   fprintf(stderr, "%d files tracked.\n", (int)FileInfo.size());
@@ -98,6 +103,9 @@ void HeaderSearch::PrintStats() {
 
   fprintf(stderr, "%d framework lookups.\n", NumFrameworkLookups);
   fprintf(stderr, "%d subframework lookups.\n", NumSubFrameworkLookups);
+
+  if (LookupCache)
+    LookupCache->PrintStats();
 }
 
 /// CreateHeaderMap - This method returns a HeaderMap for the specified
@@ -348,6 +356,11 @@ const FileEntry *DirectoryLookup::LookupFile(
       RelativePath->append(Filename.begin(), Filename.end());
     }
 
+    // Skip the stat if the directory is known not to contain the file.
+    if (HeaderLookupCache *Cache = HS.getLookupCache())
+      if (!Cache->mayContainFile(getDir(), Filename))
+        return nullptr;
+
     return HS.getFileAndSuggestModule(TmpDir, IncludeLoc, getDir(),
                                       isSystemHeaderDirectory(),
                                       RequestingModule, SuggestedModule);
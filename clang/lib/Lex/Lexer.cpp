@@ -36,6 +36,13 @@
 #include <tuple>
 #include <utility>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -1509,9 +1516,59 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
   return true;
 }
 
+/// Returns a pointer to the first character at or after \p CurPtr that is one
+/// of the characters in \p Stops, including its terminating NUL.
+///
+/// Only whole 16 byte blocks in front of \p BufferEnd are scanned, so the
+/// result may also point to the start of the last, partial block; callers
+/// finish the scan with a scalar loop. Without SSE2 this returns \p CurPtr.
+template <unsigned N>
+static const char *skipToAnyOf(const char *CurPtr, const char *BufferEnd,
+                               const char (&Stops)[N]) {
+#ifdef __SSE2__
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(CurPtr));
+    __m128i Matches = _mm_setzero_si128();
+    for (char Stop : Stops)
+      Matches = _mm_or_si128(Matches,
+                             _mm_cmpeq_epi8(Chars, _mm_set1_epi8(Stop)));
+    if (unsigned Mask = _mm_movemask_epi8(Matches))
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
+/// Returns a pointer to the first character at or after \p CurPtr that is not
+/// in [_A-Za-z0-9], with the same block-wise scanning as \c skipToAnyOf().
+static const char *skipIdentifierBody(const char *CurPtr,
+                                      const char *BufferEnd) {
+#ifdef __SSE2__
+  auto InRange = [](__m128i Chars, char Lo, char Hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(Chars, _mm_set1_epi8(Lo - 1)),
+                         _mm_cmplt_epi8(Chars, _mm_set1_epi8(Hi + 1)));
+  };
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(CurPtr));
+    // Setting bit 5 maps [A-Z] onto [a-z] and nothing else onto [a-z].
+    __m128i Folded = _mm_or_si128(Chars, _mm_set1_epi8(0x20));
+    __m128i IsBody =
+        _mm_or_si128(_mm_or_si128(InRange(Folded, 'a', 'z'),
+                                  InRange(Chars, '0', '9')),
+                     _mm_cmpeq_epi8(Chars, _mm_set1_epi8('_')));
+    if (unsigned Mask = ~_mm_movemask_epi8(IsBody) & 0xFFFF)
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  CurPtr = skipIdentifierBody(CurPtr, BufferEnd);
   unsigned char C = *CurPtr++;
   while (isIdentifierBody(C))
     C = *CurPtr++;
@@ -1772,6 +1829,11 @@ bool Lexer::LexStringLiteral(Token &Result, const char *CurPtr,
            ? diag::warn_cxx98_compat_unicode_literal
            : diag::warn_c99_compat_unicode_literal);
 
+  // Characters other than these are neither special in a string literal nor
+  // the start of an escaped newline or trigraph, so they can be skipped.
+  static const char Special[] = "\"\\\n\r?";
+
+  CurPtr = skipToAnyOf(CurPtr, BufferEnd, Special);
   char C = getAndAdvanceChar(CurPtr, Result);
   while (C != '"') {
     // Skip escaped characters.  Escaped newlines will already be processed by
@@ -1797,6 +1859,7 @@ bool Lexer::LexStringLiteral(Token &Result, const char *CurPtr,
 
       NulCharacter = CurPtr-1;
     }
+    CurPtr = skipToAnyOf(CurPtr, BufferEnd, Special);
     C = getAndAdvanceChar(CurPtr, Result);
   }
 
@@ -2054,6 +2117,32 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
   return false;
 }
 
+void Lexer::skipExcludedLineRemainder() {
+  assert(LexingRawMode && "Only skip lines in raw mode");
+  // '"' may start a raw string literal, which can span lines.
+  static const char Special[] = "\n\r/\\?\"";
+  const char *CurPtr = skipToAnyOf(BufferPtr, BufferEnd, Special);
+  while (true) {
+    switch (*CurPtr) {
+    case '\n':
+    case '\r':
+      // Leave the newline to the next call to Lex(), which will mark the
+      // following token as being at the start of a line.
+      BufferPtr = CurPtr;
+      return;
+    case 0:
+    case '/':
+    case '\\':
+    case '?':
+    case '"':
+      return;
+    default:
+      ++CurPtr;
+      break;
+    }
+  }
+}
+
 /// We have just read the // characters from input.  Skip until we find the
 /// newline character thats terminate the comment.  Then update BufferPtr and
 /// return.
@@ -2080,6 +2169,7 @@ bool Lexer::SkipLineComment(Token &Result, const char *CurPtr,
   // character that ends the line comment.
   char C;
   while (true) {
+    CurPtr = skipToAnyOf(CurPtr, BufferEnd, "\n\r");
     C = *CurPtr;
     // Skip over characters in the fast loop.
     while (C != 0 &&                // Potentially EOF.
@@ -2286,13 +2376,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
@@ -393,9 +393,12 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation IfTokenLoc,
       break;
     }
 
-    // If this token is not a preprocessor directive, just skip it.
-    if (Tok.isNot(tok::hash) || !Tok.isAtStartOfLine())
+    // If this token is not a preprocessor directive, just skip it, together
+    // with the rest of its line if that is plain code.
+    if (Tok.isNot(tok::hash) || !Tok.isAtStartOfLine()) {
+      CurLexer->skipExcludedLineRemainder();
       continue;
+    }
 
     // We just parsed a # character at the start of a line, so we're in
     // directive mode.  Tell the lexer this so any newlines we see will be
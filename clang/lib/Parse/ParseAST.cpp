@@ -16,12 +16,15 @@
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ExternalASTSource.h"
 #include "clang/AST/Stmt.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/PPCallbacks.h"
 #include "clang/Parse/ParseDiagnostic.h"
 #include "clang/Parse/Parser.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "clang/Sema/Sema.h"
 #include "clang/Sema/SemaConsumer.h"
 #include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/TimeProfiler.h"
 #include <cstdio>
 #include <memory>
 
@@ -44,6 +47,41 @@ public:
   }
 };
 
+/// Records the time spent in each included file in the time trace.
+class TimeTraceSourceCallbacks : public PPCallbacks {
+  SourceManager &SM;
+  unsigned Depth = 0;
+
+public:
+  TimeTraceSourceCallbacks(SourceManager &SM) : SM(SM) {}
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override {
+    switch (Reason) {
+    case EnterFile: {
+      FileID FID = SM.getFileID(Loc);
+      if (SM.getIncludeLoc(FID).isInvalid())
+        break;
+      ++Depth;
+      const FileEntry *FE = SM.getFileEntryForID(FID);
+      llvm::timeTraceProfilerBegin(
+          "Source", FE ? FE->getName() : StringRef("<unknown>"));
+      break;
+    }
+    case ExitFile:
+      if (Depth == 0)
+        break;
+      --Depth;
+      llvm::timeTraceProfilerEnd();
+      break;
+    case SystemHeaderPragma:
+    case RenameFile:
+      break;
+    }
+  }
+};
+
 /// If a crash happens while the parser is active, an entry is printed for it.
 class PrettyStackTraceParserEntry : public llvm::PrettyStackTraceEntry {
   const Parser &P;
@@ -135,21 +173,29 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
   llvm::CrashRecoveryContextCleanupRegistrar<Parser>
     CleanupParser(ParseOP.get());
 
-  S.getPreprocessor().EnterMainSourceFile();
-  P.Initialize();
+  if (llvm::timeTraceProfilerEnabled())
+    S.getPreprocessor().addPPCallbacks(
+        llvm::make_unique<TimeTraceSourceCallbacks>(S.getSourceManager()));
 
-  Parser::DeclGroupPtrTy ADecl;
+  S.getPreprocessor().EnterMainSourceFile();
   ExternalASTSource *External = S.getASTContext().getExternalSource();
   if (External)
     External->StartTranslationUnit(Consumer);
 
-  for (bool AtEOF = P.ParseFirstTopLevelDecl(ADecl); !AtEOF;
-       AtEOF = P.ParseTopLevelDecl(ADecl)) {
-    // If we got a null return and something *was* parsed, ignore it.  This
-    // is due to a top-level semicolon, an action override, or a parse error
-    // skipping something.
-    if (ADecl && !Consumer->HandleTopLevelDecl(ADecl.get()))
-      return;
+  {
+    // Open the scope before the first token is lexed, so that the sections of
+    // the headers included at the start of the file nest inside it.
+    llvm::TimeTraceScope TimeScope("Frontend");
+    P.Initialize();
+    Parser::DeclGroupPtrTy ADecl;
+    for (bool AtEOF = P.ParseFirstTopLevelDecl(ADecl); !AtEOF;
+         AtEOF = P.ParseTopLevelDecl(ADecl)) {
+      // If we got a null return and something *was* parsed, ignore it.  This
+      // is due to a top-level semicolon, an action override, or a parse error
+      // skipping something.
+      if (ADecl && !Consumer->HandleTopLevelDecl(ADecl.get()))
+        return;
+    }
   }
 
   // Process any TopLevelDecls generated by #pragma weak.
@@ -2322,9 +2322,13 @@ ASTReader::ReadControlBlock(ModuleFile &F,
 
       // All user input files reside at the index range [0, NumUserInputs), and
       // system input files reside at [NumUserInputs, NumInputs). For explicitly
-      // loaded module files, ignore missing inputs.
+      // loaded module files, ignore missing inputs. When validating lazily,
+      // the input files of implicit modules are checked by getInputFile() as
+      // their source location entries are loaded.
       if (!DisableValidation && F.Kind != MK_ExplicitModule &&
-          F.Kind != MK_PrebuiltModule) {
+          F.Kind != MK_PrebuiltModule &&
+          !(HSOpts.ModulesLazyValidateInputFiles &&
+            F.Kind == MK_ImplicitModule)) {
         bool Complain = (ClientLoadCapabilities & ARR_OutOfDate) == 0;
 
         // If we are reading a module, we will create a verification timestamp,
@@ -3969,9 +3973,10 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
     }
   }
 
-  if (PP.getHeaderSearchInfo()
-          .getHeaderSearchOpts()
-          .ModulesValidateOncePerBuildSession) {
+  const HeaderSearchOptions &HSOpts =
+      PP.getHeaderSearchInfo().getHeaderSearchOpts();
+  if (HSOpts.ModulesValidateOncePerBuildSession &&
+      !HSOpts.ModulesLazyValidateInputFiles) {
     // Now we are certain that the module and all modules it depends on are
     // up to date.  Create or update timestamp files for modules that are
     // located in the module cache (not for PCH files that could be anywhere
@@ -6897,13 +6902,18 @@ void ASTReader::CompleteRedeclChain(const Decl *D) {
     }
   }
 
+  // Only the specializations with the same template arguments can be
+  // redeclarations of D.
   if (auto *CTSD = dyn_cast<ClassTemplateSpecializationDecl>(D))
-    CTSD->getSpecializedTemplate()->LoadLazySpecializations();
+    CTSD->getSpecializedTemplate()->loadLazySpecializationsImpl(
+        CTSD->getTemplateArgs().asArray());
   if (auto *VTSD = dyn_cast<VarTemplateSpecializationDecl>(D))
-    VTSD->getSpecializedTemplate()->LoadLazySpecializations();
+    VTSD->getSpecializedTemplate()->loadLazySpecializationsImpl(
+        VTSD->getTemplateArgs().asArray());
   if (auto *FD = dyn_cast<FunctionDecl>(D)) {
     if (auto *Template = FD->getPrimaryTemplate())
-      Template->LoadLazySpecializations();
+      Template->loadLazySpecializationsImpl(
+          FD->getTemplateSpecializationArgs()->asArray());
   }
 }
 
@@ -20,6 +20,9 @@
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/DeclVisitor.h"
 #include "clang/AST/Expr.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/Preprocessor.h"
 #include "clang/Sema/IdentifierResolver.h"
 #include "clang/Sema/SemaDiagnostic.h"
 #include "clang/Serialization/ASTReader.h"
@@ -90,6 +93,23 @@ namespace clang {
         IDs.push_back(ReadDeclID());
     }
 
+    typedef RedeclarableTemplateDecl::LazySpecializationInfo
+        LazySpecializationInfo;
+
+    LazySpecializationInfo ReadLazySpecialization() {
+      LazySpecializationInfo Info;
+      Info.DeclID = ReadDeclID();
+      Info.ArgsHash = Record.readInt();
+      Info.IsPartial = Record.readInt();
+      return Info;
+    }
+
+    void
+    ReadLazySpecializations(SmallVectorImpl<LazySpecializationInfo> &Specs) {
+      for (unsigned I = 0, Size = Record.readInt(); I != Size; ++I)
+        Specs.push_back(ReadLazySpecialization());
+    }
+
     Decl *ReadDecl() {
       return Record.readDecl();
     }
@@ -221,8 +241,8 @@ namespace clang {
 
     template <typename T> static
     void AddLazySpecializations(T *D,
-                                SmallVectorImpl<serialization::DeclID>& IDs) {
-      if (IDs.empty())
+                               SmallVectorImpl<LazySpecializationInfo> &Specs) {
+      if (Specs.empty())
         return;
 
       // FIXME: We should avoid this pattern of getting the ASTContext.
@@ -230,15 +250,26 @@ namespace clang {
 
       auto *&LazySpecializations = D->getCommonPtr()->LazySpecializations;
 
-      if (auto &Old = LazySpecializations) {
-        IDs.insert(IDs.end(), Old + 1, Old + 1 + Old[0]);
-        std::sort(IDs.begin(), IDs.end());
-        IDs.erase(std::unique(IDs.begin(), IDs.end()), IDs.end());
-      }
-
-      auto *Result = new (C) serialization::DeclID[1 + IDs.size()];
-      *Result = IDs.size();
-      std::copy(IDs.begin(), IDs.end(), Result + 1);
+      if (auto &Old = LazySpecializations)
+        Specs.insert(Specs.end(), Old + 1, Old + 1 + Old[0].DeclID);
+
+      // Sort the specializations by the hash of their arguments, so that a
+      // lookup can binary-search for its candidates, and drop the duplicates.
+      auto LessHashAndID = [](const LazySpecializationInfo &A,
+                              const LazySpecializationInfo &B) {
+        return std::tie(A.ArgsHash, A.DeclID) < std::tie(B.ArgsHash, B.DeclID);
+      };
+      auto SameID = [](const LazySpecializationInfo &A,
+                       const LazySpecializationInfo &B) {
+        return A.DeclID == B.DeclID;
+      };
+      std::sort(Specs.begin(), Specs.end(), LessHashAndID);
+      Specs.erase(std::unique(Specs.begin(), Specs.end(), SameID),
+                  Specs.end());
+
+      auto *Result = new (C) LazySpecializationInfo[1 + Specs.size()];
+      Result[0].DeclID = Specs.size();
+      std::copy(Specs.begin(), Specs.end(), Result + 1);
 
       LazySpecializations = Result;
     }
@@ -271,7 +302,7 @@ namespace clang {
     void ReadFunctionDefinition(FunctionDecl *FD);
     void Visit(Decl *D);
 
-    void UpdateDecl(Decl *D, llvm::SmallVectorImpl<serialization::DeclID>&);
+    void UpdateDecl(Decl *D, llvm::SmallVectorImpl<LazySpecializationInfo> &);
 
     static void setNextObjCCategory(ObjCCategoryDecl *Cat,
                                     ObjCCategoryDecl *Next) {
@@ -2003,9 +2034,9 @@ void ASTDeclReader::VisitClassTemplateDecl(ClassTemplateDecl *D) {
   if (ThisDeclID == Redecl.getFirstID()) {
     // This ClassTemplateDecl owns a CommonPtr; read it to keep track of all of
     // the specializations.
-    SmallVector<serialization::DeclID, 32> SpecIDs;
-    ReadDeclIDList(SpecIDs);
-    ASTDeclReader::AddLazySpecializations(D, SpecIDs);
+    SmallVector<LazySpecializationInfo, 32> Specs;
+    ReadLazySpecializations(Specs);
+    ASTDeclReader::AddLazySpecializations(D, Specs);
   }
 
   if (D->getTemplatedDecl()->TemplateOrInstantiation) {
@@ -2030,9 +2061,9 @@ void ASTDeclReader::VisitVarTemplateDecl(VarTemplateDecl *D) {
   if (ThisDeclID == Redecl.getFirstID()) {
     // This VarTemplateDecl owns a CommonPtr; read it to keep track of all of
     // the specializations.
-    SmallVector<serialization::DeclID, 32> SpecIDs;
-    ReadDeclIDList(SpecIDs);
-    ASTDeclReader::AddLazySpecializations(D, SpecIDs);
+    SmallVector<LazySpecializationInfo, 32> Specs;
+    ReadLazySpecializations(Specs);
+    ASTDeclReader::AddLazySpecializations(D, Specs);
   }
 }
 
@@ -2136,9 +2167,9 @@ void ASTDeclReader::VisitFunctionTemplateDecl(FunctionTemplateDecl *D) {
 
   if (ThisDeclID == Redecl.getFirstID()) {
     // This FunctionTemplateDecl owns a CommonPtr; read it.
-    SmallVector<serialization::DeclID, 32> SpecIDs;
-    ReadDeclIDList(SpecIDs);
-    ASTDeclReader::AddLazySpecializations(D, SpecIDs);
+    SmallVector<LazySpecializationInfo, 32> Specs;
+    ReadLazySpecializations(Specs);
+    ASTDeclReader::AddLazySpecializations(D, Specs);
   }
 }
 
@@ -3355,6 +3386,18 @@ Decl *ASTReader::ReadDeclRecord(DeclID ID) {
   unsigned Index = ID - NUM_PREDEF_DECL_IDS;
   SourceLocation DeclLoc;
   RecordLocation Loc = DeclCursorForID(ID, DeclLoc);
+
+  // When the input files of implicit modules are validated lazily, validate
+  // the file of this declaration before it is used. Reading the declaration
+  // only remaps its source locations, which does not load the source
+  // location entry, and so the input file, that they belong to.
+  if (!DisableValidation && Loc.F->Kind == MK_ImplicitModule &&
+      DeclLoc.isValid() &&
+      PP.getHeaderSearchInfo()
+          .getHeaderSearchOpts()
+          .ModulesLazyValidateInputFiles)
+    (void)SourceMgr.getFileID(SourceMgr.getFileLoc(DeclLoc));
+
   llvm::BitstreamCursor &DeclsCursor = Loc.F->DeclsCursor;
   // Keep track of where we are in the stream, then jump back there
   // after reading this declaration.
@@ -3685,7 +3728,8 @@ void ASTReader::loadDeclUpdateRecords(PendingUpdateRecord &Record) {
   ProcessingUpdatesRAIIObj ProcessingUpdates(*this);
   DeclUpdateOffsetsMap::iterator UpdI = DeclUpdateOffsets.find(ID);
 
-  llvm::SmallVector<serialization::DeclID, 8> PendingLazySpecializationIDs;
+  llvm::SmallVector<RedeclarableTemplateDecl::LazySpecializationInfo, 8>
+      PendingLazySpecializations;
 
   if (UpdI != DeclUpdateOffsets.end()) {
     auto UpdateOffsets = std::move(UpdI->second);
@@ -3711,7 +3755,7 @@ void ASTReader::loadDeclUpdateRecords(PendingUpdateRecord &Record) {
 
       ASTDeclReader Reader(*this, Record, RecordLocation(F, Offset), ID,
                            SourceLocation());
-      Reader.UpdateDecl(D, PendingLazySpecializationIDs);
+      Reader.UpdateDecl(D, PendingLazySpecializations);
 
       // We might have made this declaration interesting. If so, remember that
       // we need to hand it off to the consumer.
@@ -3724,16 +3768,16 @@ void ASTReader::loadDeclUpdateRecords(PendingUpdateRecord &Record) {
     }
   }
   // Add the lazy specializations to the template.
-  assert((PendingLazySpecializationIDs.empty() || isa<ClassTemplateDecl>(D) ||
+  assert((PendingLazySpecializations.empty() || isa<ClassTemplateDecl>(D) ||
           isa<FunctionTemplateDecl>(D) || isa<VarTemplateDecl>(D)) &&
          "Must not have pending specializations");
   if (auto *CTD = dyn_cast<ClassTemplateDecl>(D))
-    ASTDeclReader::AddLazySpecializations(CTD, PendingLazySpecializationIDs);
+    ASTDeclReader::AddLazySpecializations(CTD, PendingLazySpecializations);
   else if (auto *FTD = dyn_cast<FunctionTemplateDecl>(D))
-    ASTDeclReader::AddLazySpecializations(FTD, PendingLazySpecializationIDs);
+    ASTDeclReader::AddLazySpecializations(FTD, PendingLazySpecializations);
   else if (auto *VTD = dyn_cast<VarTemplateDecl>(D))
-    ASTDeclReader::AddLazySpecializations(VTD, PendingLazySpecializationIDs);
-  PendingLazySpecializationIDs.clear();
+    ASTDeclReader::AddLazySpecializations(VTD, PendingLazySpecializations);
+  PendingLazySpecializations.clear();
 
   // Load the pending visible updates for this decl context, if it has any.
   auto I = PendingVisibleUpdates.find(ID);
@@ -3931,7 +3975,7 @@ static void forAllLaterRedecls(DeclT *D, Fn F) {
 }
 
 void ASTDeclReader::UpdateDecl(Decl *D,
-   llvm::SmallVectorImpl<serialization::DeclID> &PendingLazySpecializationIDs) {
+    llvm::SmallVectorImpl<LazySpecializationInfo> &PendingLazySpecializations) {
   while (Record.getIdx() < Record.size()) {
     switch ((DeclUpdateKind)Record.readInt()) {
     case UPD_CXX_ADDED_IMPLICIT_MEMBER: {
@@ -3948,7 +3992,7 @@ void ASTDeclReader::UpdateDecl(Decl *D,
 
     case UPD_CXX_ADDED_TEMPLATE_SPECIALIZATION:
       // It will be added to the template's lazy specialization set.
-      PendingLazySpecializationIDs.push_back(ReadDeclID());
+      PendingLazySpecializations.push_back(ReadLazySpecialization());
       break;
 
     case UPD_CXX_ADDED_ANONYMOUS_NAMESPACE: {
@@ -165,7 +165,8 @@ namespace clang {
     /// Add to the record the first declaration from each module file that
     /// provides a declaration of D. The intent is to provide a sufficient
     /// set such that reloading this set will load all current redeclarations.
-    void AddFirstDeclFromEachModule(const Decl *D, bool IncludeLocal) {
+    llvm::MapVector<ModuleFile*, const Decl*>
+    getFirstDeclFromEachModule(const Decl *D, bool IncludeLocal) {
       llvm::MapVector<ModuleFile*, const Decl*> Firsts;
       // FIXME: We can skip entries that we know are implied by others.
       for (const Decl *R = D->getMostRecentDecl(); R; R = R->getPreviousDecl()) {
@@ -174,10 +175,31 @@ namespace clang {
         else if (IncludeLocal)
           Firsts[nullptr] = R;
       }
-      for (const auto &F : Firsts)
+      return Firsts;
+    }
+
+    void AddFirstDeclFromEachModule(const Decl *D, bool IncludeLocal) {
+      for (const auto &F : getFirstDeclFromEachModule(D, IncludeLocal))
         Record.AddDeclRef(F.second);
     }
 
+    /// Add a reference to the specialization \p D of \p Template, along with
+    /// the hash of its template arguments and whether it is a partial
+    /// specialization, in the format read by ReadLazySpecialization().
+    void AddLazySpecialization(const RedeclarableTemplateDecl *Template,
+                               const Decl *D, bool IncludeLocal) {
+      unsigned Hash = Template->computeSpecializationHash(D);
+      bool IsPartial = isa<ClassTemplatePartialSpecializationDecl>(D) ||
+                       isa<VarTemplatePartialSpecializationDecl>(D);
+
+      // All the declarations of the specialization have the same arguments.
+      for (const auto &F : getFirstDeclFromEachModule(D, IncludeLocal)) {
+        Record.AddDeclRef(F.second);
+        Record.push_back(Hash);
+        Record.push_back(IsPartial);
+      }
+    }
+
     /// Get the specialization decl from an entry in the specialization list.
     template <typename EntryType>
     typename RedeclarableTemplateDecl::SpecEntryTraits<EntryType>::DeclType *
@@ -207,9 +229,12 @@ namespace clang {
         assert(!Common->LazySpecializations);
       }
 
-      ArrayRef<DeclID> LazySpecializations;
+      // Loading specializations below removes them from the lazy array, so
+      // take a copy of it first.
+      llvm::SmallVector<RedeclarableTemplateDecl::LazySpecializationInfo, 16>
+          LazySpecializations;
       if (auto *LS = Common->LazySpecializations)
-        LazySpecializations = llvm::makeArrayRef(LS + 1, LS[0]);
+        LazySpecializations.append(LS + 1, LS + 1 + LS[0].DeclID);
 
       // Add a slot to the record for the number of specializations.
       unsigned I = Record.size();
@@ -223,14 +248,22 @@ namespace clang {
       for (auto &Entry : getPartialSpecializations(Common))
         Specs.push_back(getSpecializationDecl(Entry));
 
-      for (auto *D : Specs) {
-        assert(D->isCanonicalDecl() && "non-canonical decl in set");
-        AddFirstDeclFromEachModule(D, /*IncludeLocal*/true);
+      unsigned NumSpecs = 0;
+      for (auto *Spec : Specs) {
+        assert(Spec->isCanonicalDecl() && "non-canonical decl in set");
+        unsigned Begin = Record.size();
+        AddLazySpecialization(D, Spec, /*IncludeLocal*/true);
+        NumSpecs += (Record.size() - Begin) / 3;
+      }
+      for (const auto &LS : LazySpecializations) {
+        Record.push_back(LS.DeclID);
+        Record.push_back(LS.ArgsHash);
+        Record.push_back(LS.IsPartial);
+        ++NumSpecs;
       }
-      Record.append(LazySpecializations.begin(), LazySpecializations.end());
 
       // Update the size entry we added earlier.
-      Record[I] = Record.size() - I - 1;
+      Record[I] = NumSpecs;
     }
 
     /// Ensure that this template specialization is associated with the specified
@@ -386,7 +386,9 @@ namespace {
     ImportedModuleFileInfo(off_t Size, time_t ModTime, ASTFileSignature Sig)
         : StoredSize(Size), StoredModTime(ModTime), StoredSignature(Sig) {}
   };
+}
 
+namespace clang {
   /// \brief Builder that generates the global module index file.
   class GlobalModuleIndexBuilder {
     FileManager &FileMgr;
@@ -440,6 +442,17 @@ namespace {
     /// \returns true if an error occurred, false otherwise.
     bool loadModuleFile(const FileEntry *File);
 
+    /// \brief Record a module file that has not changed since a previous
+    /// index was built, with the dependencies that index recorded for it,
+    /// without reading it.
+    void addUnchangedModuleFile(const FileEntry *File,
+                                ArrayRef<const FileEntry *> Dependencies);
+
+    /// \brief Record that the given identifier is interesting in each of
+    /// the given module files, as recorded by a previous index.
+    void addInterestingIdentifier(StringRef Name,
+                                  ArrayRef<const FileEntry *> Files);
+
     /// \brief Write the index to the given bitstream.
     /// \returns true if an error occurred, false otherwise.
     bool writeIndex(llvm::BitstreamWriter &Stream);
@@ -679,6 +692,22 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
   return false;
 }
 
+void GlobalModuleIndexBuilder::addUnchangedModuleFile(
+    const FileEntry *File, ArrayRef<const FileEntry *> Dependencies) {
+  getModuleFileInfo(File);
+  for (const FileEntry *DependsOnFile : Dependencies) {
+    unsigned DependsOnID = getModuleFileInfo(DependsOnFile).ID;
+    getModuleFileInfo(File).Dependencies.push_back(DependsOnID);
+  }
+}
+
+void GlobalModuleIndexBuilder::addInterestingIdentifier(
+    StringRef Name, ArrayRef<const FileEntry *> Files) {
+  SmallVectorImpl<unsigned> &IDs = InterestingIdentifiers[Name];
+  for (const FileEntry *File : Files)
+    IDs.push_back(getModuleFileInfo(File).ID);
+}
+
 namespace {
 
 /// \brief Trait used to generate the identifier index as an on-disk hash
@@ -813,6 +842,61 @@ bool GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
   return false;
 }
 
+void GlobalModuleIndex::addUnchangedModules(
+    FileManager &FileMgr, GlobalModuleIndexBuilder &Builder,
+    llvm::SmallPtrSetImpl<const FileEntry *> &UnchangedFiles) const {
+  // Find the module files whose size and modification time still match.
+  SmallVector<const FileEntry *, 16> Files(Modules.size());
+  for (unsigned ID = 0, N = Modules.size(); ID != N; ++ID) {
+    const ModuleInfo &Info = Modules[ID];
+    if (Info.FileName.empty())
+      continue;
+    const FileEntry *File = FileMgr.getFile(Info.FileName, /*openFile=*/false,
+                                            /*cacheFailure=*/false);
+    if (File && File->getSize() == Info.Size &&
+        File->getModificationTime() == Info.ModTime)
+      Files[ID] = File;
+  }
+
+  // A module file is only known to be consistent with its dependencies if
+  // none of them changed either; the others are read again.
+  for (unsigned ID = 0, N = Modules.size(); ID != N; ++ID) {
+    if (!Files[ID])
+      continue;
+    SmallVector<const FileEntry *, 4> Dependencies;
+    for (unsigned DependsOnID : Modules[ID].Dependencies) {
+      if (DependsOnID >= N || !Files[DependsOnID]) {
+        Dependencies.clear();
+        break;
+      }
+      Dependencies.push_back(Files[DependsOnID]);
+    }
+    if (Dependencies.size() != Modules[ID].Dependencies.size())
+      continue;
+
+    Builder.addUnchangedModuleFile(Files[ID], Dependencies);
+    UnchangedFiles.insert(Files[ID]);
+  }
+
+  if (!IdentifierIndex)
+    return;
+
+  // Carry over the identifiers of the unchanged module files. Identifiers no
+  // module file finds interesting are kept as well: the index then still
+  // knows that they are not worth looking up.
+  IdentifierIndexTable &Table =
+      *static_cast<IdentifierIndexTable *>(IdentifierIndex);
+  for (auto Key = Table.key_begin(), KeyEnd = Table.key_end(); Key != KeyEnd;
+       ++Key) {
+    SmallVector<unsigned, 2> ModuleIDs = *Table.find(*Key);
+    SmallVector<const FileEntry *, 2> InterestingFiles;
+    for (unsigned ID : ModuleIDs)
+      if (ID < Files.size() && UnchangedFiles.count(Files[ID]))
+        InterestingFiles.push_back(Files[ID]);
+    Builder.addInterestingIdentifier(*Key, InterestingFiles);
+  }
+}
+
 GlobalModuleIndex::ErrorCode
 GlobalModuleIndex::writeIndex(FileManager &FileMgr,
                               const PCHContainerReader &PCHContainerRdr,
@@ -841,6 +925,12 @@ GlobalModuleIndex::writeIndex(FileManager &FileMgr,
   // The module index builder.
   GlobalModuleIndexBuilder Builder(FileMgr, PCHContainerRdr);
 
+  // Carry over the module files that did not change since the previous index
+  // was built, so that only new and rebuilt module files need to be read.
+  llvm::SmallPtrSet<const FileEntry *, 16> UnchangedFiles;
+  if (std::unique_ptr<GlobalModuleIndex> PreviousIndex{readIndex(Path).first})
+    PreviousIndex->addUnchangedModules(FileMgr, Builder, UnchangedFiles);
+
   // Load each of the module files.
   std::error_code EC;
   for (llvm::sys::fs::directory_iterator D(Path, EC), DEnd;
@@ -857,9 +947,10 @@ GlobalModuleIndex::writeIndex(FileManager &FileMgr,
       continue;
     }
 
-    // If we can't find the module file, skip it.
+    // If we can't find the module file, or already know its contents, skip
+    // it.
     const FileEntry *ModuleFile = FileMgr.getFile(D->path());
-    if (!ModuleFile)
+    if (!ModuleFile || UnchangedFiles.count(ModuleFile))
       continue;
 
     // Load this module file.
@@ -0,0 +1,536 @@
+//=== FunctionSummariesChecker.cpp ------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This defines FunctionSummariesChecker, which records a summary of the
+// behavior of each function analyzed as top level, and uses the summaries
+// recorded while analyzing other translation units to evaluate calls to
+// functions whose body is not available.
+//
+// The summaries are stored in the directory given by the 'SummaryDir' option,
+// and the checker does nothing without it. Each translation unit writes a
+// <main file>-<hash>.fsum text file, with one "<flags> <USR>" line per
+// function. When the analysis of the translation unit is sharded, each shard
+// writes its own file. The first analysis that needs them merges these files
+// into an on-disk hash table, summaries.idx, which is mapped by the following
+// analyses. Changing a summary file removes the index, so that it is rebuilt
+// with the new summaries; writing the same summaries again keeps it.
+//
+// Analyzing the code base twice thus makes the summaries of the first run
+// available to the second one, at the cost of one hash table lookup per call.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ClangSACheckers.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Index/USRGeneration.h"
+#include "clang/StaticAnalyzer/Core/BugReporter/BugReporter.h"
+#include "clang/StaticAnalyzer/Core/Checker.h"
+#include "clang/StaticAnalyzer/Core/CheckerManager.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+using namespace ento;
+
+namespace {
+
+/// The facts a summary may record about a function.
+enum SummaryFlags : uint32_t {
+  /// No path through the function returns to its caller.
+  SF_NoReturn = 1 << 0,
+  /// The function returns a pointer that is never null.
+  SF_ReturnsNonNull = 1 << 1
+};
+
+const char SummaryFileExtension[] = ".fsum";
+const char IndexFileName[] = "summaries.idx";
+const char IndexMagic[4] = {'C', 'F', 'S', 'I'};
+const uint32_t IndexVersion = 1;
+const unsigned IndexHeaderSize = 12;
+
+class SummaryIndexTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef uint32_t data_type;
+  typedef uint32_t data_type_ref;
+  typedef uint32_t hash_value_type;
+  typedef uint32_t offset_type;
+
+  static hash_value_type ComputeHash(StringRef Key) {
+    return llvm::HashString(Key);
+  }
+
+  static bool EqualKey(StringRef A, StringRef B) { return A == B; }
+
+  static StringRef GetInternalKey(StringRef Key) { return Key; }
+  static StringRef GetExternalKey(StringRef Key) { return Key; }
+
+  static std::pair<offset_type, offset_type>
+  EmitKeyDataLength(raw_ostream &Out, StringRef Key, data_type_ref) {
+    using namespace llvm::support;
+    offset_type KeyLen = Key.size();
+    endian::Writer<little>(Out).write<offset_type>(KeyLen);
+    return std::make_pair(KeyLen, sizeof(data_type));
+  }
+
+  static void EmitKey(raw_ostream &Out, StringRef Key, offset_type) {
+    Out << Key;
+  }
+
+  static void EmitData(raw_ostream &Out, StringRef, data_type_ref Flags,
+                       offset_type) {
+    using namespace llvm::support;
+    endian::Writer<little>(Out).write<data_type>(Flags);
+  }
+
+  static std::pair<offset_type, offset_type>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    offset_type KeyLen = endian::readNext<offset_type, little, unaligned>(D);
+    return std::make_pair(KeyLen, sizeof(data_type));
+  }
+
+  static StringRef ReadKey(const unsigned char *D, offset_type KeyLen) {
+    return StringRef(reinterpret_cast<const char *>(D), KeyLen);
+  }
+
+  static data_type ReadData(StringRef, const unsigned char *D, offset_type) {
+    using namespace llvm::support;
+    return endian::readNext<data_type, little, unaligned>(D);
+  }
+};
+
+/// The merged summaries of the functions of all the translation units,
+/// mapped from the index file.
+class SummaryIndex {
+  typedef llvm::OnDiskChainedHashTable<SummaryIndexTrait> OnDiskTable;
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<OnDiskTable> Table;
+
+  SummaryIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
+               std::unique_ptr<OnDiskTable> Table)
+      : Buffer(std::move(Buffer)), Table(std::move(Table)) {}
+
+  static std::unique_ptr<SummaryIndex> read(StringRef IndexPath);
+  static bool write(StringRef Dir, StringRef IndexPath);
+
+public:
+  /// Loads the index of the summaries in \p Dir, building it first if needed.
+  /// Returns null if there is no usable index.
+  static std::unique_ptr<SummaryIndex> load(StringRef Dir);
+
+  /// Returns the flags summarizing the function with the given USR.
+  uint32_t lookup(StringRef USR) const {
+    auto It = Table->find(USR);
+    return It == Table->end() ? 0 : *It;
+  }
+};
+
+class FunctionSummariesChecker
+    : public Checker<check::PreStmt<ReturnStmt>, check::EndFunction,
+                     check::EndAnalysis, check::PostCall,
+                     check::EndOfTranslationUnit> {
+  /// What was seen on the paths through a function analyzed as top level.
+  struct PathsInfo {
+    bool Returns = false;
+    bool MayReturnNull = false;
+  };
+
+  mutable llvm::DenseMap<const Decl *, PathsInfo> Paths;
+
+  /// The summaries of the functions of this translation unit, by USR.
+  mutable llvm::StringMap<uint32_t> Summaries;
+
+  mutable std::unique_ptr<SummaryIndex> Index;
+  mutable bool IndexLoaded = false;
+
+  static bool getUSR(const Decl *D, SmallVectorImpl<char> &USR);
+
+  void loadIndex() const;
+  bool isNoReturnSink(const ExplodedNode *N) const;
+
+public:
+  std::string SummaryDir;
+
+  void checkPreStmt(const ReturnStmt *RS, CheckerContext &C) const;
+  void checkEndFunction(CheckerContext &C) const;
+  void checkEndAnalysis(ExplodedGraph &G, BugReporter &BR,
+                        ExprEngine &Eng) const;
+  void checkPostCall(const CallEvent &Call, CheckerContext &C) const;
+  void checkEndOfTranslationUnit(const TranslationUnitDecl *TU,
+                                 AnalysisManager &Mgr, BugReporter &BR) const;
+};
+
+} // end anonymous namespace
+
+//===----------------------------------------------------------------------===//
+// Summary index.
+//===----------------------------------------------------------------------===//
+
+std::unique_ptr<SummaryIndex> SummaryIndex::read(StringRef IndexPath) {
+  auto BufferOrErr = llvm::MemoryBuffer::getFile(IndexPath, /*FileSize=*/-1,
+                                                 /*RequiresNullTerminator=*/
+                                                 false);
+  if (!BufferOrErr)
+    return nullptr;
+
+  StringRef Data = (*BufferOrErr)->getBuffer();
+  if (Data.size() < IndexHeaderSize ||
+      !Data.startswith(StringRef(IndexMagic, sizeof(IndexMagic))))
+    return nullptr;
+  using namespace llvm::support;
+  const unsigned char *Base =
+      reinterpret_cast<const unsigned char *>(Data.data());
+  const unsigned char *Ptr = Base + sizeof(IndexMagic);
+  uint32_t Version = endian::readNext<uint32_t, little, unaligned>(Ptr);
+  uint32_t TableOffset = endian::readNext<uint32_t, little, unaligned>(Ptr);
+  if (Version != IndexVersion || TableOffset % 4 != 0 ||
+      TableOffset < IndexHeaderSize ||
+      uint64_t(TableOffset) + 2 * sizeof(uint32_t) > Data.size())
+    return nullptr;
+
+  std::unique_ptr<OnDiskTable> Table(
+      OnDiskTable::Create(Base + TableOffset, Base));
+  return std::unique_ptr<SummaryIndex>(
+      new SummaryIndex(std::move(*BufferOrErr), std::move(Table)));
+}
+
+bool SummaryIndex::write(StringRef Dir, StringRef IndexPath) {
+  // Merge the summary files. A function summarized by several translation
+  // units, e.g. an inline function, only keeps the facts they all agree on.
+  llvm::StringMap<uint32_t> Merged;
+  std::error_code EC;
+  for (llvm::sys::fs::directory_iterator D(Dir, EC), DEnd; D != DEnd && !EC;
+       D.increment(EC)) {
+    if (llvm::sys::path::extension(D->path()) != SummaryFileExtension)
+      continue;
+    auto BufferOrErr = llvm::MemoryBuffer::getFile(D->path());
+    if (!BufferOrErr)
+      continue;
+
+    SmallVector<StringRef, 64> Lines;
+    (*BufferOrErr)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                                      /*KeepEmpty=*/false);
+    for (StringRef Line : Lines) {
+      StringRef FlagsStr, USR;
+      std::tie(FlagsStr, USR) = Line.split(' ');
+      uint32_t Flags;
+      if (USR.empty() || FlagsStr.getAsInteger(10, Flags))
+        continue;
+      auto Insertion = Merged.insert(std::make_pair(USR, Flags));
+      if (!Insertion.second)
+        Insertion.first->second &= Flags;
+    }
+  }
+  if (EC)
+    return true;
+
+  llvm::OnDiskChainedHashTableGenerator<SummaryIndexTrait> Generator;
+  for (const auto &Entry : Merged)
+    Generator.insert(Entry.first(), Entry.second);
+
+  SmallString<4096> Contents;
+  {
+    llvm::raw_svector_ostream Out(Contents);
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    Out.write(IndexMagic, sizeof(IndexMagic));
+    LE.write<uint32_t>(IndexVersion);
+    LE.write<uint32_t>(0); // Patched below.
+    uint32_t TableOffset = Generator.Emit(Out);
+    endian::write<uint32_t, little, unaligned>(
+        Contents.data() + sizeof(IndexMagic) + sizeof(uint32_t), TableOffset);
+  }
+
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(IndexPath + "-%%%%%%%%", FD, TempPath))
+    return true;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out << Contents;
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return true;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath, IndexPath)) {
+    llvm::sys::fs::remove(TempPath);
+    return true;
+  }
+  return false;
+}
+
+std::unique_ptr<SummaryIndex> SummaryIndex::load(StringRef Dir) {
+  SmallString<128> IndexPath(Dir);
+  llvm::sys::path::append(IndexPath, IndexFileName);
+  if (auto Index = read(IndexPath))
+    return Index;
+
+  // Build the index, coordinating with the other analyses that may try to do
+  // the same.
+  llvm::LockFileManager Locked(IndexPath);
+  switch (Locked) {
+  case llvm::LockFileManager::LFS_Error:
+    return nullptr;
+
+  case llvm::LockFileManager::LFS_Owned:
+    if (write(Dir, IndexPath))
+      return nullptr;
+    break;
+
+  case llvm::LockFileManager::LFS_Shared:
+    if (Locked.waitForUnlock() != llvm::LockFileManager::Res_Success)
+      return nullptr;
+    break;
+  }
+  return read(IndexPath);
+}
+
+//===----------------------------------------------------------------------===//
+// FunctionSummariesChecker.
+//===----------------------------------------------------------------------===//
+
+bool FunctionSummariesChecker::getUSR(const Decl *D,
+                                      SmallVectorImpl<char> &USR) {
+  // Only functions visible from other translation units are worth a summary.
+  const auto *FD = dyn_cast_or_null<FunctionDecl>(D);
+  if (!FD || !FD->isExternallyVisible())
+    return false;
+  return !index::generateUSRForDecl(FD->getCanonicalDecl(), USR);
+}
+
+void FunctionSummariesChecker::loadIndex() const {
+  if (!IndexLoaded) {
+    IndexLoaded = true;
+    if (!SummaryDir.empty())
+      Index = SummaryIndex::load(SummaryDir);
+  }
+}
+
+/// Returns true if the path ending at the sink \p N stopped at a call that
+/// does not return, rather than on a bug or on an analysis limit.
+bool FunctionSummariesChecker::isNoReturnSink(const ExplodedNode *N) const {
+  Optional<StmtPoint> SP = N->getLocationAs<StmtPoint>();
+  if (!SP)
+    return false;
+  const auto *CE = dyn_cast<CallExpr>(SP->getStmt());
+  if (!CE)
+    return false;
+  const FunctionDecl *FD = CE->getDirectCallee();
+  if (!FD)
+    return false;
+  if (FD->isNoReturn())
+    return true;
+
+  // The sinks added for the calls summarized as not returning.
+  if (FD->hasBody())
+    return false;
+  loadIndex();
+  SmallString<128> USR;
+  return Index && getUSR(FD, USR) && (Index->lookup(USR) & SF_NoReturn);
+}
+
+void FunctionSummariesChecker::checkPreStmt(const ReturnStmt *RS,
+                                            CheckerContext &C) const {
+  if (!C.inTopFrame())
+    return;
+
+  PathsInfo &Info = Paths[C.getLocationContext()->getDecl()];
+  if (Info.MayReturnNull)
+    return;
+
+  const Expr *RetE = RS->getRetValue();
+  if (!RetE || !RetE->getType()->isAnyPointerType())
+    return;
+
+  Optional<DefinedOrUnknownSVal> RetVal =
+      C.getSVal(RetE).getAs<DefinedOrUnknownSVal>();
+  if (!RetVal || C.getState()->assume(*RetVal, false))
+    Info.MayReturnNull = true;
+}
+
+void FunctionSummariesChecker::checkEndFunction(CheckerContext &C) const {
+  if (C.inTopFrame())
+    Paths[C.getLocationContext()->getDecl()].Returns = true;
+}
+
+void FunctionSummariesChecker::checkEndAnalysis(ExplodedGraph &G,
+                                                BugReporter &BR,
+                                                ExprEngine &Eng) const {
+  if (SummaryDir.empty() || G.roots_begin() == G.roots_end())
+    return;
+  const Decl *D = (*G.roots_begin())->getLocationContext()->getDecl();
+  PathsInfo Info = Paths.lookup(D);
+  Paths.erase(D);
+
+  SmallString<128> USR;
+  if (!getUSR(D, USR))
+    return;
+
+  uint32_t Flags = 0;
+  if (!Info.Returns)
+    Flags |= SF_NoReturn;
+  else if (cast<FunctionDecl>(D)->getReturnType()->isAnyPointerType() &&
+           !Info.MayReturnNull)
+    Flags |= SF_ReturnsNonNull;
+
+  // Only a complete exploration of the function tells anything about all of
+  // its paths. The engine leaves work behind when it runs out of steps or
+  // memory, or exhausts the block visits of a path, and a path also ends in a
+  // sink when a block is visited too often or a checker finds a bug on it.
+  // Record that nothing is known then, so that the other analyses of the
+  // function do not claim more.
+  if (Flags) {
+    if (Eng.hasWorkRemaining() || Eng.wasBlocksExhausted()) {
+      Flags = 0;
+    } else {
+      for (auto I = G.nodes_begin(), E = G.nodes_end(); I != E; ++I) {
+        if (I->isSink() && !isNoReturnSink(&*I)) {
+          Flags = 0;
+          break;
+        }
+      }
+    }
+  }
+
+  // The function may be analyzed more than once, e.g. with and without
+  // Objective-C garbage collection: keep what holds in every analysis.
+  auto Insertion = Summaries.insert(std::make_pair(USR, Flags));
+  if (!Insertion.second)
+    Insertion.first->second &= Flags;
+}
+
+void FunctionSummariesChecker::checkPostCall(const CallEvent &Call,
+                                             CheckerContext &C) const {
+  // Calls to functions defined in this translation unit are evaluated from
+  // their definition.
+  const auto *FD = dyn_cast_or_null<FunctionDecl>(Call.getDecl());
+  if (!FD || FD->hasBody())
+    return;
+
+  loadIndex();
+  if (!Index)
+    return;
+
+  SmallString<128> USR;
+  if (!getUSR(FD, USR))
+    return;
+  uint32_t Flags = Index->lookup(USR);
+
+  if (Flags & SF_NoReturn) {
+    C.generateSink(C.getState(), C.getPredecessor());
+    return;
+  }
+
+  if (Flags & SF_ReturnsNonNull) {
+    Optional<DefinedOrUnknownSVal> RetVal =
+        Call.getReturnValue().getAs<DefinedOrUnknownSVal>();
+    if (!RetVal)
+      return;
+    if (ProgramStateRef State = C.getState()->assume(*RetVal, true))
+      C.addTransition(State);
+  }
+}
+
+void FunctionSummariesChecker::checkEndOfTranslationUnit(
+    const TranslationUnitDecl *TU, AnalysisManager &Mgr,
+    BugReporter &BR) const {
+  if (SummaryDir.empty() || Summaries.empty())
+    return;
+
+  const SourceManager &SM = Mgr.getSourceManager();
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  if (!MainFile)
+    return;
+
+  // Name the summary file after the main file, so that analyzing a file again
+  // replaces its summaries, and after the shard, as every shard writes the
+  // summaries of the functions it analyzed.
+  std::string Name = (llvm::sys::path::stem(MainFile->getName()) + "-" +
+                      llvm::utohexstr(llvm::hash_value(MainFile->getName())))
+                         .str();
+  AnalyzerOptions &Opts = Mgr.getAnalyzerOptions();
+  if (Opts.getAnalysisShardCount() > 1)
+    Name += "-" + llvm::utostr(Opts.getAnalysisShardIndex()) + "of" +
+            llvm::utostr(Opts.getAnalysisShardCount());
+  SmallString<128> SummaryPath(SummaryDir);
+  llvm::sys::path::append(SummaryPath, Name + SummaryFileExtension);
+
+  // Sort the summaries, so that analyzing a file again writes the same
+  // contents.
+  std::vector<std::pair<StringRef, uint32_t>> Sorted;
+  for (const auto &Entry : Summaries)
+    Sorted.push_back(std::make_pair(Entry.first(), Entry.second));
+  std::sort(Sorted.begin(), Sorted.end());
+  std::string Contents;
+  {
+    llvm::raw_string_ostream Out(Contents);
+    for (const auto &Entry : Sorted)
+      Out << Entry.second << ' ' << Entry.first << '\n';
+  }
+
+  // Leave the summary file, and with it the index, alone if the summaries
+  // did not change. Otherwise every analysis that uses the index would also
+  // invalidate it.
+  if (auto OldBufferOrErr = llvm::MemoryBuffer::getFile(SummaryPath))
+    if ((*OldBufferOrErr)->getBuffer() == Contents)
+      return;
+
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(SummaryPath + "-%%%%%%%%", FD, TempPath))
+    return;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out << Contents;
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath, SummaryPath)) {
+    llvm::sys::fs::remove(TempPath);
+    return;
+  }
+
+  // The index no longer reflects the summaries; the next analysis that needs
+  // it rebuilds it.
+  SmallString<128> IndexPath(SummaryDir);
+  llvm::sys::path::append(IndexPath, IndexFileName);
+  llvm::sys::fs::remove(IndexPath);
+}
+
+void ento::registerFunctionSummariesChecker(CheckerManager &Mgr) {
+  auto *Checker = Mgr.registerChecker<FunctionSummariesChecker>();
+  Checker->SummaryDir =
+      Mgr.getAnalyzerOptions().getOptionAsString("SummaryDir", "", Checker);
+}
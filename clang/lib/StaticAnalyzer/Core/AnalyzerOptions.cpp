@@ -363,6 +363,12 @@ bool AnalyzerOptions::shouldConditionalizeStaticInitializers() {
   return getBooleanOption("cfg-conditional-static-initializers", true);
 }
 
+unsigned AnalyzerOptions::getMaxGraphMemory() {
+  if (!MaxGraphMemory.hasValue())
+    MaxGraphMemory = getOptionAsInteger("max-graph-memory", 0);
+  return MaxGraphMemory.getValue();
+}
+
 bool AnalyzerOptions::shouldInlineLambdas() {
   if (!InlineLambdas.hasValue())
     InlineLambdas = getBooleanOption("inline-lambdas", /*Default=*/true);
@@ -381,3 +387,17 @@ bool AnalyzerOptions::shouldDisplayNotesAsEvents() {
         getBooleanOption("notes-as-events", /*Default=*/false);
   return DisplayNotesAsEvents.getValue();
 }
+
+unsigned AnalyzerOptions::getAnalysisShardCount() {
+  if (!AnalysisShardCount.hasValue()) {
+    int Count = getOptionAsInteger("shard-count", 1);
+    AnalysisShardCount = Count > 1 ? Count : 1;
+  }
+  return AnalysisShardCount.getValue();
+}
+
+unsigned AnalyzerOptions::getAnalysisShardIndex() {
+  if (!AnalysisShardIndex.hasValue())
+    AnalysisShardIndex = getOptionAsInteger("shard-index", 0);
+  return AnalysisShardIndex.getValue();
+}
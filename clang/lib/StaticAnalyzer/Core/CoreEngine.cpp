@@ -32,6 +32,20 @@ STATISTIC(NumReachedMaxSteps,
             "The # of times we reached the max number of steps.");
 STATISTIC(NumPathsExplored,
             "The # of paths explored by the analyzer.");
+STATISTIC(NumReachedMemoryBudget,
+            "The # of times we reached the memory budget of the graph.");
+STATISTIC(MaxNodesInGraph,
+            "The maximum # of nodes in the graph of a top level function.");
+STATISTIC(MaxGraphMemoryKB,
+            "The maximum memory (in KB) used by the graph and states of a "
+            "top level function.");
+STATISTIC(MaxStatesInterned,
+            "The maximum # of states interned for a top level function.");
+STATISTIC(NumNodesReclaimed,
+            "The # of nodes reclaimed from the graph.");
+
+/// How many steps to run between two checks of the memory budget.
+static const unsigned MemoryCheckInterval = 1024;
 
 //===----------------------------------------------------------------------===//
 // Worklist classes for exploration of reachable states.
@@ -213,6 +227,8 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
   if(!UnlimitedSteps)
     G.reserve(std::min(Steps,PreReservationCap));
 
+  unsigned StepsUntilMemoryCheck = MemoryCheckInterval;
+  unsigned NumReclaimedBefore = G.getNumReclaimedNodes();
   while (WList->hasWork()) {
     if (!UnlimitedSteps) {
       if (Steps == 0) {
@@ -222,6 +238,22 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
       --Steps;
     }
 
+    if (MemoryBudget && --StepsUntilMemoryCheck == 0) {
+      StepsUntilMemoryCheck = MemoryCheckInterval;
+      // Most of the memory of the analysis, including the nodes, the states
+      // and the environment and store maps, comes from the graph allocator.
+      uint64_t Used = G.getAllocator().getTotalMemory();
+      if (Used >= MemoryBudget) {
+        NumReachedMemoryBudget++;
+        break;
+      }
+      if (Used >= MemoryBudget / 2) {
+        if (!G.isReclaimingNodes())
+          G.enableNodeReclamation(MemoryCheckInterval);
+        G.enableAggressiveNodeReclamation();
+      }
+    }
+
     NumSteps++;
 
     const WorkListUnit& WU = WList->dequeue();
@@ -235,6 +267,12 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
     dispatchWorkItem(Node, Node->getLocation(), WU);
   }
   SubEng.processEndWorklist(hasWorkRemaining());
+
+  MaxNodesInGraph.updateMax(G.size());
+  MaxGraphMemoryKB.updateMax(G.getAllocator().getTotalMemory() / 1024);
+  MaxStatesInterned.updateMax(SubEng.getStateManager().getNumStates());
+  NumNodesReclaimed += G.getNumReclaimedNodes() - NumReclaimedBefore;
+
   return WList->hasWork();
 }
 
@@ -91,6 +91,9 @@ ExprEngine::ExprEngine(AnalysisManager &mgr, bool gcEnabled,
     // Enable eager node reclaimation when constructing the ExplodedGraph.
     G.enableNodeReclamation(TrimInterval);
   }
+
+  if (unsigned MaxMemory = mgr.options.getMaxGraphMemory())
+    Engine.setMemoryBudget(uint64_t(MaxMemory) << 20);
 }
 
 ExprEngine::~ExprEngine() {
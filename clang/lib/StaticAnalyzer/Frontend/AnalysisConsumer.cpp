@@ -23,6 +23,7 @@
 #include "clang/Analysis/CodeInjector.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/StaticAnalyzer/Checkers/LocalCheckers.h"
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
@@ -33,6 +34,9 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Frontend/CheckerRegistration.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/FileSystem.h"
@@ -161,6 +165,13 @@ class AnalysisConsumer : public AnalysisASTConsumer,
   /// Bug Reporter to use while recursively visiting Decls.
   BugReporter *RecVisitorBR;
 
+  /// The number of shards the translation unit is analyzed in, and the one
+  /// analyzed by this consumer.
+  unsigned ShardCount;
+  unsigned ShardIndex;
+  /// The shard of each function of the call graph, by canonical declaration.
+  llvm::DenseMap<const Decl *, unsigned> ShardOfDecl;
+
 public:
   ASTContext *Ctx;
   const Preprocessor &PP;
@@ -195,7 +206,8 @@ public:
   AnalysisConsumer(const Preprocessor &pp, const std::string &outdir,
                    AnalyzerOptionsRef opts, ArrayRef<std::string> plugins,
                    CodeInjector *injector)
-      : RecVisitorMode(0), RecVisitorBR(nullptr), Ctx(nullptr), PP(pp),
+      : RecVisitorMode(0), RecVisitorBR(nullptr), ShardCount(1),
+        ShardIndex(0), Ctx(nullptr), PP(pp),
         OutDir(outdir), Opts(std::move(opts)), Plugins(plugins),
         Injector(injector) {
     DigestAnalyzerOptions();
@@ -385,6 +397,13 @@ private:
   /// \brief Check if we should skip (not analyze) the given function.
   AnalysisMode getModeForDecl(Decl *D, AnalysisMode Mode);
 
+  /// \brief Check if the given function is path-sensitively analyzed by the
+  /// shard of this consumer.
+  bool isInAnalysisShard(const Decl *D) const;
+
+  /// \brief Assign the functions of the call graph to the shards.
+  void assignAnalysisShards(const CallGraph &CG);
+
 };
 } // end anonymous namespace
 
@@ -467,6 +486,9 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
     CG.addToCallGraph(LocalTUDecls[i]);
   }
 
+  if (ShardCount > 1)
+    assignAnalysisShards(CG);
+
   // Walk over all of the call graph nodes in topological order, so that we
   // analyze parents before the children. Skip the functions inlined into
   // the previously processed functions. Use external Visited set to identify
@@ -519,13 +541,22 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   if (Opts->DisableAllChecks)
     return;
 
+  ShardCount = Opts->getAnalysisShardCount();
+  ShardIndex = Opts->getAnalysisShardIndex();
+  if (ShardIndex >= ShardCount) {
+    Diags.Report(diag::err_analyzer_shard_index_out_of_range)
+        << Opts->Config["shard-index"] << ShardCount - 1;
+    return;
+  }
+
   {
     if (TUTotalTimer) TUTotalTimer->startTimer();
 
     // Introduce a scope to destroy BR before Mgr.
     BugReporter BR(*Mgr);
     TranslationUnitDecl *TU = C.getTranslationUnitDecl();
-    checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
+    if (ShardIndex == 0)
+      checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
 
     // Run the AST-only checks using the order in which functions are defined.
     // If inlining is not turned on, use the simplest function order for path
@@ -550,6 +581,8 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
       HandleDeclsCallGraph(LocalTUDeclsSize);
 
     // After all decls handled, run checkers on the entire TranslationUnit.
+    // This happens in every shard, as the checkers may have gathered
+    // something about the functions analyzed in it.
     checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
 
     RecVisitorBR = nullptr;
@@ -651,12 +684,144 @@ AnalysisConsumer::getModeForDecl(Decl *D, AnalysisMode Mode) {
   if (!Opts->AnalyzeAll && !SM.isWrittenInMainFile(SL)) {
     if (SL.isInvalid() || SM.isInSystemHeader(SL))
       return AM_None;
-    return Mode & ~AM_Path;
+    Mode &= ~AM_Path;
   }
 
+  // When the analysis is sharded, the syntactic checks run in the first shard
+  // and each function is path-sensitively analyzed as top level in a single
+  // shard.
+  if (ShardIndex != 0)
+    Mode &= ~AM_Syntax;
+  if ((Mode & AM_Path) && !isInAnalysisShard(D))
+    Mode &= ~AM_Path;
+
   return Mode;
 }
 
+bool AnalysisConsumer::isInAnalysisShard(const Decl *D) const {
+  if (ShardCount == 1)
+    return true;
+
+  D = D->getCanonicalDecl();
+  auto I = ShardOfDecl.find(D);
+  if (I != ShardOfDecl.end())
+    return I->second == ShardIndex;
+
+  // Without inlining, each function is analyzed on its own. Assign it by
+  // location, which is the same in every process analyzing this translation
+  // unit.
+  size_t Hash = llvm::hash_value(D->getLocation().getRawEncoding());
+  return Hash % ShardCount == ShardIndex;
+}
+
+namespace {
+/// Collects the functions a function body may call that the call graph does
+/// not record: constructors, destructors and allocation functions, and the
+/// virtual methods and Objective-C messages that are dispatched dynamically.
+class ImplicitCalleeCollector
+    : public RecursiveASTVisitor<ImplicitCalleeCollector> {
+public:
+  SmallVector<const Decl *, 8> Callees;
+
+  bool VisitCallExpr(CallExpr *CE) {
+    if (const auto *MD = dyn_cast_or_null<CXXMethodDecl>(CE->getDirectCallee()))
+      if (MD->isVirtual())
+        Callees.push_back(MD);
+    return true;
+  }
+
+  bool VisitCXXConstructExpr(CXXConstructExpr *CE) {
+    Callees.push_back(CE->getConstructor());
+    addDestructor(CE->getType());
+    return true;
+  }
+
+  bool VisitCXXNewExpr(CXXNewExpr *NE) {
+    if (const FunctionDecl *FD = NE->getOperatorNew())
+      Callees.push_back(FD);
+    return true;
+  }
+
+  bool VisitCXXDeleteExpr(CXXDeleteExpr *DE) {
+    if (const FunctionDecl *FD = DE->getOperatorDelete())
+      Callees.push_back(FD);
+    addDestructor(DE->getDestroyedType());
+    return true;
+  }
+
+  bool VisitObjCMessageExpr(ObjCMessageExpr *ME) {
+    if (const ObjCMethodDecl *MD = ME->getMethodDecl())
+      Callees.push_back(MD);
+    return true;
+  }
+
+private:
+  void addDestructor(QualType T) {
+    if (T.isNull())
+      return;
+    const CXXRecordDecl *RD =
+        T->getBaseElementTypeUnsafe()->getAsCXXRecordDecl();
+    if (RD && RD->hasDefinition())
+      if (const CXXDestructorDecl *DD = RD->getDestructor())
+        Callees.push_back(DD);
+  }
+};
+} // end anonymous namespace
+
+void AnalysisConsumer::assignAnalysisShards(const CallGraph &CG) {
+  // A function analyzed as top level in one shard and inlined in another
+  // would be reported on by both. Keep the functions that may be inlined into
+  // one another, directly or through a common callee, in the same shard: each
+  // shard then analyzes its functions exactly as a single process would.
+  llvm::EquivalenceClasses<const Decl *> Groups;
+  for (const auto &Entry : CG) {
+    const Decl *D = Entry.first;
+    if (!D)
+      continue;
+    D = D->getCanonicalDecl();
+    Groups.insert(D);
+
+    for (const CallGraphNode *Callee : *Entry.second)
+      Groups.unionSets(D, Callee->getDecl()->getCanonicalDecl());
+
+    // Blocks are inlined into the function that defines them.
+    if (isa<BlockDecl>(D))
+      if (const auto *Parent =
+              dyn_cast_or_null<Decl>(D->getParentFunctionOrMethod()))
+        Groups.unionSets(D, Parent->getCanonicalDecl());
+
+    // A dynamically dispatched call may be inlined into any override.
+    if (const auto *MD = dyn_cast<CXXMethodDecl>(D))
+      for (const CXXMethodDecl *Overridden : MD->overridden_methods())
+        Groups.unionSets(D, Overridden->getCanonicalDecl());
+    if (const auto *MD = dyn_cast<ObjCMethodDecl>(D)) {
+      SmallVector<const ObjCMethodDecl *, 4> Overridden;
+      MD->getOverriddenMethods(Overridden);
+      for (const ObjCMethodDecl *O : Overridden)
+        Groups.unionSets(D, O->getCanonicalDecl());
+    }
+
+    ImplicitCalleeCollector Collector;
+    Collector.TraverseDecl(const_cast<Decl *>(Entry.first));
+    for (const Decl *Callee : Collector.Callees)
+      Groups.unionSets(D, Callee->getCanonicalDecl());
+  }
+
+  // Assign each group by the first location of its functions, which is the
+  // same in every process analyzing this translation unit.
+  ShardOfDecl.clear();
+  for (auto I = Groups.begin(), E = Groups.end(); I != E; ++I) {
+    if (!I->isLeader())
+      continue;
+    unsigned FirstLoc = ~0U;
+    for (auto M = Groups.member_begin(I); M != Groups.member_end(); ++M)
+      FirstLoc = std::min(FirstLoc, (*M)->getLocation().getRawEncoding());
+    unsigned Shard = llvm::hash_value(FirstLoc) % ShardCount;
+    for (auto M = Groups.member_begin(I); M != Groups.member_end(); ++M)
+      ShardOfDecl[*M] = Shard;
+  }
+}
+
 void AnalysisConsumer::HandleCode(Decl *D, AnalysisMode Mode,
                                   ExprEngine::InliningModes IMode,
                                   SetOfConstDecls *VisitedCallees) {
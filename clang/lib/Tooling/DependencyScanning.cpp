@@ -0,0 +1,253 @@
+//===- DependencyScanning.cpp - Fast dependency scanning ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/DependencyScanning.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include <thread>
+
+using namespace clang;
+using namespace tooling;
+
+/// \brief Returns true if the contents of \p Filename can be minimized.
+///
+/// Module maps are not preprocessed, and precompiled files are not even text.
+static bool shouldMinimize(StringRef Filename) {
+  StringRef Name = llvm::sys::path::filename(Filename);
+  if (Name == "module.map" || Name == "module.private.map")
+    return false;
+  StringRef Ext = llvm::sys::path::extension(Name);
+  return Ext != ".modulemap" && Ext != ".pcm" && Ext != ".pch" &&
+         Ext != ".gch";
+}
+
+CachedFileSystemEntry CachedFileSystemEntry::create(StringRef Filename,
+                                                    vfs::FileSystem &FS,
+                                                    bool Minimize) {
+  CachedFileSystemEntry Result;
+  Result.MaybeStat = FS.status(Filename);
+  if (!Result.MaybeStat || !Result.MaybeStat->isRegularFile())
+    return Result;
+
+  auto MaybeBuffer = FS.getBufferForFile(Filename);
+  if (!MaybeBuffer) {
+    Result.MaybeStat = MaybeBuffer.getError();
+    return Result;
+  }
+  StringRef Buffer = (*MaybeBuffer)->getBuffer();
+
+  SmallString<0> MinimizedContents;
+  if (Minimize && !minimizeSourceToDependencyDirectives(Buffer,
+                                                        MinimizedContents)) {
+    Result.Contents = MinimizedContents.str();
+    Result.Minimized = true;
+  } else {
+    // Fall back to the original contents if the minimizer could not make
+    // sense of the file, the preprocessor will diagnose it.
+    Result.Contents = Buffer;
+  }
+
+  const vfs::Status &Stat = *Result.MaybeStat;
+  Result.MaybeStat = vfs::Status(
+      Stat.getName(), Stat.getUniqueID(), Stat.getLastModificationTime(),
+      Stat.getUser(), Stat.getGroup(), Result.Contents.size(), Stat.getType(),
+      Stat.getPermissions());
+  return Result;
+}
+
+DependencyScanningFilesystemSharedCache::
+    DependencyScanningFilesystemSharedCache()
+    : Shards(std::max(std::thread::hardware_concurrency(), 1u) * 4) {}
+
+DependencyScanningFilesystemSharedCache::CacheShard &
+DependencyScanningFilesystemSharedCache::getShard(StringRef Key) {
+  return Shards[llvm::HashString(Key) % Shards.size()];
+}
+
+namespace {
+
+/// \brief A file whose contents are owned by a \c CachedFileSystemEntry.
+class MinimizedVFSFile : public vfs::File {
+public:
+  MinimizedVFSFile(const CachedFileSystemEntry &Entry, const Twine &Name)
+      : Stat(vfs::Status::copyWithNewName(*Entry.getStatus(), Name.str())),
+        Contents(Entry.getContents()) {}
+
+  llvm::ErrorOr<vfs::Status> status() override { return Stat; }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    // The contents are a std::string, so they are always null terminated.
+    return llvm::MemoryBuffer::getMemBuffer(Contents, Name.str(),
+                                            RequiresNullTerminator);
+  }
+
+  std::error_code close() override { return std::error_code(); }
+
+private:
+  vfs::Status Stat;
+  StringRef Contents;
+};
+
+} // end anonymous namespace
+
+DependencyScanningFilesystem::DependencyScanningFilesystem(
+    DependencyScanningFilesystemSharedCache &SharedCache,
+    IntrusiveRefCntPtr<vfs::FileSystem> UnderlyingFS)
+    : SharedCache(SharedCache), UnderlyingFS(std::move(UnderlyingFS)) {
+  if (auto CWD = this->UnderlyingFS->getCurrentWorkingDirectory())
+    WorkingDirectory = *CWD;
+}
+
+llvm::ErrorOr<const CachedFileSystemEntry *>
+DependencyScanningFilesystem::getEntry(const Twine &Path) {
+  SmallString<256> Filename;
+  Path.toVector(Filename);
+  if (std::error_code EC = makeAbsolute(Filename))
+    return EC;
+
+  auto It = LocalCache.find(Filename);
+  if (It != LocalCache.end())
+    return It->second;
+
+  const CachedFileSystemEntry &Entry =
+      SharedCache.getOrCreate(Filename, [&] {
+        return CachedFileSystemEntry::create(Filename, *UnderlyingFS,
+                                             shouldMinimize(Filename));
+      });
+  LocalCache[Filename] = &Entry;
+  return &Entry;
+}
+
+llvm::ErrorOr<vfs::Status>
+DependencyScanningFilesystem::status(const Twine &Path) {
+  auto Entry = getEntry(Path);
+  if (!Entry)
+    return Entry.getError();
+  const llvm::ErrorOr<vfs::Status> &Stat = (*Entry)->getStatus();
+  if (!Stat)
+    return Stat.getError();
+  return vfs::Status::copyWithNewName(*Stat, Path.str());
+}
+
+llvm::ErrorOr<std::unique_ptr<vfs::File>>
+DependencyScanningFilesystem::openFileForRead(const Twine &Path) {
+  auto Entry = getEntry(Path);
+  if (!Entry)
+    return Entry.getError();
+  const llvm::ErrorOr<vfs::Status> &Stat = (*Entry)->getStatus();
+  if (!Stat)
+    return Stat.getError();
+  if (Stat->isDirectory())
+    return std::make_error_code(std::errc::is_a_directory);
+  return std::unique_ptr<vfs::File>(new MinimizedVFSFile(**Entry, Path));
+}
+
+vfs::directory_iterator
+DependencyScanningFilesystem::dir_begin(const Twine &Dir, std::error_code &EC) {
+  SmallString<256> Path;
+  Dir.toVector(Path);
+  EC = makeAbsolute(Path);
+  if (EC)
+    return vfs::directory_iterator();
+  return UnderlyingFS->dir_begin(Path, EC);
+}
+
+llvm::ErrorOr<std::string>
+DependencyScanningFilesystem::getCurrentWorkingDirectory() const {
+  return WorkingDirectory;
+}
+
+std::error_code
+DependencyScanningFilesystem::setCurrentWorkingDirectory(const Twine &Path) {
+  SmallString<256> Dir;
+  Path.toVector(Dir);
+  if (std::error_code EC = makeAbsolute(Dir))
+    return EC;
+  WorkingDirectory = Dir.str();
+  return std::error_code();
+}
+
+namespace {
+
+/// \brief Runs the preprocessor only, whatever the command line asked for,
+/// so that the dependency file is written without compiling anything.
+class DependencyScanningAction : public ToolAction {
+public:
+  DependencyScanningAction(StringRef WorkingDirectory)
+      : WorkingDirectory(WorkingDirectory) {}
+
+  bool runInvocation(std::shared_ptr<CompilerInvocation> Invocation,
+                     FileManager *Files,
+                     std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+                     DiagnosticConsumer *DiagConsumer) override {
+    CompilerInstance Compiler(std::move(PCHContainerOps));
+    Compiler.setInvocation(std::move(Invocation));
+    Compiler.setFileManager(Files);
+    Compiler.createDiagnostics(DiagConsumer, /*ShouldOwnClient=*/false);
+    if (!Compiler.hasDiagnostics())
+      return false;
+
+    // Only the commands that ask for a dependency file are scanned; the
+    // others have nothing to write.
+    DependencyOutputOptions &DepOpts = Compiler.getDependencyOutputOpts();
+    if (DepOpts.OutputFile.empty())
+      return true;
+
+    // The dependency file is written directly to disk, not through the file
+    // system, so resolve it against the command's directory.
+    if (DepOpts.OutputFile != "-" &&
+        !llvm::sys::path::is_absolute(DepOpts.OutputFile)) {
+      SmallString<256> DepFile(WorkingDirectory);
+      llvm::sys::path::append(DepFile, DepOpts.OutputFile);
+      DepOpts.OutputFile = DepFile.str();
+    }
+
+    Compiler.createSourceManager(*Files);
+    PreprocessOnlyAction Action;
+    return Compiler.ExecuteAction(Action);
+  }
+
+private:
+  StringRef WorkingDirectory;
+};
+
+} // end anonymous namespace
+
+DependencyScanningWorker::DependencyScanningWorker(
+    DependencyScanningFilesystemSharedCache &SharedCache,
+    IntrusiveRefCntPtr<vfs::FileSystem> UnderlyingFS)
+    : DepFS(new DependencyScanningFilesystem(SharedCache,
+                                             std::move(UnderlyingFS))) {}
+
+bool DependencyScanningWorker::runOnCommand(
+    const std::vector<std::string> &CommandLine, StringRef WorkingDirectory,
+    DiagnosticConsumer *DiagConsumer) {
+  // This only changes the working directory of DepFS, which never calls
+  // chdir, so workers on different threads do not interfere.
+  if (DepFS->setCurrentWorkingDirectory(WorkingDirectory))
+    return false;
+  // The file manager caches relative paths, so use a fresh one for each
+  // command; the file system keeps the cached entries alive across commands.
+  IntrusiveRefCntPtr<FileManager> Files(
+      new FileManager(FileSystemOptions(), DepFS));
+  DependencyScanningAction Action(WorkingDirectory);
+  ToolInvocation Invocation(CommandLine, &Action, Files.get(),
+                            std::make_shared<PCHContainerOperations>());
+  Invocation.setDiagnosticConsumer(DiagConsumer);
+  return Invocation.run();
+}
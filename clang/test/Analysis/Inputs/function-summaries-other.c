@@ -0,0 +1,23 @@
+void abort(void) __attribute__((__noreturn__));
+
+int Global;
+
+int *getNonNull(void) {
+  return &Global;
+}
+
+int *getMaybeNull(int x) {
+  return x ? &Global : 0;
+}
+
+void fatal(const char *msg) {
+  (void)msg;
+  abort();
+}
+
+// Every path ends on a bug, which is not a reason to summarize the function
+// as not returning.
+int divide(int x) {
+  int Zero = 0;
+  return x / Zero;
+}
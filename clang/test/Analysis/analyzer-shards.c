@@ -0,0 +1,58 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores %s 2> %t.all
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores -analyzer-config shard-count=2,shard-index=0 %s 2> %t.0
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,deadcode.DeadStores -analyzer-config shard-count=2,shard-index=1 %s 2> %t.1
+// RUN: cat %t.0 %t.1 | FileCheck %s
+// RUN: FileCheck --check-prefix=SHARD1 %s < %t.1
+
+// Together, the shards report exactly what a single analysis does.
+// RUN: grep "warning:" %t.all | sort > %t.expected
+// RUN: cat %t.0 %t.1 | grep "warning:" | sort > %t.sharded
+// RUN: diff %t.expected %t.sharded
+// RUN: grep -c "warning:" %t.sharded | FileCheck --check-prefix=COUNT %s
+// COUNT: {{^}}5{{$}}
+
+// The end-of-translation-unit checks run in every shard.
+// RUN: %clang_analyze_cc1 -analyzer-checker=debug.ConfigDumper -analyzer-config shard-count=2,shard-index=1 %s 2>&1 | FileCheck --check-prefix=ENDOFTU %s
+// ENDOFTU: [config]
+// ENDOFTU: shard-index = 1
+
+// RUN: not %clang_analyze_cc1 -analyzer-checker=core -analyzer-config shard-count=2,shard-index=2 %s 2>&1 | FileCheck --check-prefix=BADINDEX %s
+// RUN: not %clang_analyze_cc1 -analyzer-checker=core -analyzer-config shard-count=2,shard-index=-1 %s 2>&1 | FileCheck --check-prefix=BADINDEX %s
+// BADINDEX: error: analyzer-config option 'shard-index' is '{{-?[0-9]+}}', but must be between 0 and 1
+
+int f1(void) {
+  int *p = 0;
+  return *p; // CHECK-DAG: analyzer-shards.c:[[@LINE]]:{{[0-9]+}}: warning: Dereference of null pointer
+}
+
+int f2(void) {
+  int *p = 0;
+  return *p; // CHECK-DAG: analyzer-shards.c:[[@LINE]]:{{[0-9]+}}: warning: Dereference of null pointer
+}
+
+int f3(void) {
+  int *p = 0;
+  return *p; // CHECK-DAG: analyzer-shards.c:[[@LINE]]:{{[0-9]+}}: warning: Dereference of null pointer
+}
+
+void f4(void) {
+  int x = 0;
+  x = 1; // CHECK-DAG: analyzer-shards.c:[[@LINE]]:{{[0-9]+}}: warning: Value stored to 'x' is never read
+}
+
+// The callers and the callee are analyzed in the same shard, which reports
+// the null dereference found by inlining once.
+int deref(int *p) {
+  return *p; // CHECK-DAG: analyzer-shards.c:[[@LINE]]:{{[0-9]+}}: warning: Dereference of null pointer
+}
+
+int g1(void) {
+  return deref(0);
+}
+
+int g2(void) {
+  int *q = 0;
+  return deref(q);
+}
+
+// SHARD1-NOT: Value stored
@@ -0,0 +1,59 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection,alpha.core.FunctionSummaries -analyzer-config alpha.core.FunctionSummaries:SummaryDir=%t -DNO_SUMMARIES -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,alpha.core.FunctionSummaries -analyzer-config alpha.core.FunctionSummaries:SummaryDir=%t %S/Inputs/function-summaries-other.c
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection,alpha.core.FunctionSummaries -analyzer-config alpha.core.FunctionSummaries:SummaryDir=%t -verify %s
+
+// Analyzing a file again with the same summaries keeps the index.
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection,alpha.core.FunctionSummaries -analyzer-config alpha.core.FunctionSummaries:SummaryDir=%t -verify %s
+// RUN: ls %t | FileCheck --check-prefix=INDEX %s
+// INDEX: summaries.idx
+
+// Without a summary directory, the checker does nothing.
+// RUN: rm -rf %t.cwd && mkdir %t.cwd && cd %t.cwd
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection,alpha.core.FunctionSummaries -DNO_SUMMARIES -verify %s
+// RUN: ls %t.cwd | count 0
+
+// Each shard of a sharded analysis writes the summaries of its functions.
+// RUN: rm -rf %t.shards && mkdir %t.shards
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,alpha.core.FunctionSummaries -analyzer-config alpha.core.FunctionSummaries:SummaryDir=%t.shards -analyzer-config shard-count=2,shard-index=0 %S/Inputs/function-summaries-other.c
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,alpha.core.FunctionSummaries -analyzer-config alpha.core.FunctionSummaries:SummaryDir=%t.shards -analyzer-config shard-count=2,shard-index=1 %S/Inputs/function-summaries-other.c
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection,alpha.core.FunctionSummaries -analyzer-config alpha.core.FunctionSummaries:SummaryDir=%t.shards -verify %s
+
+// The summaries of the functions defined in the other file are only
+// available once it has been analyzed.
+
+void clang_analyzer_warnIfReached(void);
+
+int *getNonNull(void);
+int *getMaybeNull(int x);
+void fatal(const char *msg);
+int divide(int x);
+
+void testReturnsNonNull(void) {
+  int *p = getNonNull();
+  if (!p) {
+#ifdef NO_SUMMARIES
+    // expected-warning@+2 {{REACHABLE}}
+#endif
+    clang_analyzer_warnIfReached();
+  }
+}
+
+void testMayReturnNull(int x) {
+  int *p = getMaybeNull(x);
+  if (!p)
+    clang_analyzer_warnIfReached(); // expected-warning{{REACHABLE}}
+}
+
+void testNoReturn(void) {
+  fatal("unreachable");
+#ifdef NO_SUMMARIES
+  // expected-warning@+2 {{REACHABLE}}
+#endif
+  clang_analyzer_warnIfReached();
+}
+
+void testCutShort(void) {
+  divide(1);
+  clang_analyzer_warnIfReached(); // expected-warning{{REACHABLE}}
+}
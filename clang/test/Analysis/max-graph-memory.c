@@ -0,0 +1,27 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.Stats -analyzer-config max-nodes=0,max-graph-memory=1 -verify %s
+
+// The 2^16 paths of this function do not fit in 1 MB: the analysis must stop
+// once the memory budget is exhausted, even with no limit on the steps.
+
+int foo(void);
+
+int test(void) { // expected-warning-re{{test -> Total CFGBlocks: {{[0-9]+}} | Unreachable CFGBlocks: {{[0-9]+}} | Exhausted Block: no | Empty WorkList: no}}
+  int x = 0;
+  if (foo()) x += 1;
+  if (foo()) x += 2;
+  if (foo()) x += 3;
+  if (foo()) x += 4;
+  if (foo()) x += 5;
+  if (foo()) x += 6;
+  if (foo()) x += 7;
+  if (foo()) x += 8;
+  if (foo()) x += 9;
+  if (foo()) x += 10;
+  if (foo()) x += 11;
+  if (foo()) x += 12;
+  if (foo()) x += 13;
+  if (foo()) x += 14;
+  if (foo()) x += 15;
+  if (foo()) x += 16;
+  return x;
+}
@@ -0,0 +1,6 @@
+#ifndef HEADER_H
+#define HEADER_H
+
+#define HEADER2 "header2.h"
+
+#endif
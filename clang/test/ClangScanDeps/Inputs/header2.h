@@ -0,0 +1,2 @@
+// This file is only included through a macro.
+int header2;
@@ -0,0 +1,27 @@
+// RUN: rm -rf %t.dir
+// RUN: mkdir -p %t.dir/Inputs
+// RUN: cp %s %t.dir/regular_cdb.cpp
+// RUN: cp %S/Inputs/header.h %S/Inputs/header2.h %t.dir/Inputs
+// RUN: sed -e "s|DIR|%/t.dir|g" %S/Inputs/regular_cdb.json > %t.cdb
+//
+// RUN: clang-scan-deps -compilation-database %t.cdb -j 1
+// RUN: %clang -M %t.dir/regular_cdb.cpp -I%t.dir/Inputs \
+// RUN:   -MF %t.dir/expected.d
+// RUN: diff %t.dir/expected.d %t.dir/regular_cdb.d
+// RUN: FileCheck %s < %t.dir/regular_cdb.d
+//
+// A command that does not ask for dependencies gets no dependency file.
+// RUN: not ls %t.dir/no_deps.d
+
+#include "header.h"
+#include HEADER2
+
+// #include "commented_out.h"
+#if 0
+#include "excluded.h"
+#endif
+
+// CHECK: regular_cdb.o: {{.*}}regular_cdb.cpp
+// CHECK-NEXT: Inputs{{/|\\}}header.h
+// CHECK-NEXT: Inputs{{/|\\}}header2.h
+// CHECK-NOT: excluded.h
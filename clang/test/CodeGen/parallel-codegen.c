@@ -0,0 +1,40 @@
+// REQUIRES: x86-registered-target
+// RUN: %clang_cc1 -triple x86_64-unknown-linux -O1 -emit-obj %s -o %t.0.o \
+// RUN:   -parallel-codegen-output %t.1.o
+// RUN: llvm-nm -defined-only %t.0.o %t.1.o | grep " [A-Za-z] " | sort -k3 \
+// RUN:   | FileCheck %s
+// RUN: llvm-nm -defined-only %t.0.o %t.1.o | grep " [A-Za-z] " | count 4
+
+// Every function is code generated in exactly one of the partitions, and
+// local functions stay local.
+// CHECK: T callfabs
+// CHECK-NEXT: T f1
+// CHECK-NEXT: T f2
+// CHECK-NEXT: t helper
+// CHECK-NOT: {{.}}
+
+// The partitions use the library info of the command line.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux -O1 -emit-obj %s -o %t.0.o \
+// RUN:   -parallel-codegen-output %t.1.o -fno-builtin-fabs
+// RUN: llvm-nm %t.0.o %t.1.o | FileCheck --check-prefix=NOBUILTIN %s
+// NOBUILTIN: U fabs
+
+// The diagnostics of the partitions are reported with their location.
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux -O1 -emit-obj %s \
+// RUN:   -o %t.0.o -parallel-codegen-output %t.1.o -DBAD_ASM 2>&1 \
+// RUN:   | FileCheck --check-prefix=BADASM %s
+// BADASM: parallel-codegen.c:{{[0-9]+}}:{{[0-9]+}}: error: invalid instruction mnemonic 'bogus_instruction'
+
+static int __attribute__((noinline)) helper(int x) { return x * 3; }
+
+int f1(int x) { return helper(x) + 1; }
+
+int f2(int x) { return x - 1; }
+
+double fabs(double);
+
+double callfabs(double x) { return fabs(x); }
+
+#ifdef BAD_ASM
+void bad(void) { __asm__("bogus_instruction"); }
+#endif
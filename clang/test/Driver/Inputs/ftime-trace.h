@@ -0,0 +1,4 @@
+template <typename T>
+struct Struct {
+  T Num;
+};
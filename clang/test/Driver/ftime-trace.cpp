@@ -0,0 +1,31 @@
+// RUN: %clangxx -### -ftime-trace -ftime-trace-granularity=0 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=DRIVER %s
+// DRIVER: "-cc1"{{.*}} "-ftime-trace" "-ftime-trace-granularity=0"
+
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clangxx -S -ftime-trace -ftime-trace-granularity=0 -o %t/check-time-trace.s %s
+// RUN: FileCheck %s < %t/check-time-trace.json
+
+// A section is written when it ends. The header included at the start of the
+// file is parsed within the Frontend section, so its Source section is
+// written first.
+// CHECK: "traceEvents":[
+// CHECK: "name":"Source","args":{"detail":"{{[^"]*}}Inputs/ftime-trace.h"}
+// CHECK: "name":"Frontend"
+// CHECK-DAG: "name":"Total ExecuteCompiler"
+// CHECK-DAG: "name":"Total Frontend"
+// CHECK-DAG: "name":"Total InstantiateFunction"
+// CHECK-DAG: "name":"Total CodeGen Function"
+// CHECK: ]}
+
+#include "Inputs/ftime-trace.h"
+
+template <typename T>
+T sum(const Struct<T> &S) {
+  return S.Num;
+}
+
+int foo() {
+  Struct<int> S = {1};
+  return sum(S);
+}
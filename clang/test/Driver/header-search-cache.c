@@ -0,0 +1,6 @@
+// RUN: %clang -fheader-search-cache=%t.cache -### -c %s 2>&1 | FileCheck %s
+// CHECK: "-cc1"
+// CHECK-SAME: "-fheader-search-cache={{.*}}.cache"
+
+// RUN: %clang -### -c %s 2>&1 | FileCheck %s -check-prefix=CHECK-NONE
+// CHECK-NONE-NOT: -fheader-search-cache
@@ -0,0 +1,32 @@
+// RUN: %clang -### -target x86_64-unknown-linux -c -fparallel-codegen=3 %s -o %t.o 2>&1 \
+// RUN:   | FileCheck %s
+// CHECK: "-cc1"
+// CHECK-SAME: "-o" "[[P0:[^"]*parallel-codegen-[^"]*\.o]]"
+// CHECK-SAME: "-parallel-codegen-output" "[[P1:[^"]*\.o]]"
+// CHECK-SAME: "-parallel-codegen-output" "[[P2:[^"]*\.o]]"
+// CHECK-NEXT: "-r" "-o" "{{.*}}.o" "[[P0]]" "[[P1]]" "[[P2]]"
+
+// The time trace is written next to the final object file, not next to the
+// first partition.
+// RUN: %clang -### -target x86_64-unknown-linux -c -fparallel-codegen=3 \
+// RUN:   -ftime-trace %s -o %t.o 2>&1 | FileCheck -check-prefix=TIME-TRACE %s
+// TIME-TRACE: "-cc1"
+// TIME-TRACE-SAME: "-ftime-trace"
+// TIME-TRACE-SAME: "-o" "{{[^"]*}}parallel-codegen-{{[^"]*}}.o"
+// TIME-TRACE-SAME: "-time-trace-file={{[^"]*}}parallel-codegen.c.tmp.json"
+// TIME-TRACE-NEXT: "-r"
+
+// RUN: %clang -### -target x86_64-unknown-linux -c -fparallel-codegen=1 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=SERIAL %s
+// RUN: %clang -### -target x86_64-unknown-linux -S -fparallel-codegen=3 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=SERIAL %s
+// SERIAL-NOT: "-parallel-codegen-output"
+// SERIAL-NOT: "-r"
+
+// RUN: %clang -### -target x86_64-unknown-linux -c -fparallel-codegen=x %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=INVALID %s
+// INVALID: error: invalid integral value 'x' in '-fparallel-codegen=x'
+
+// RUN: %clang -### -target x86_64-apple-darwin -c -fparallel-codegen=2 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=UNSUPPORTED %s
+// UNSUPPORTED: error: unsupported option '-fparallel-codegen=2' for target '{{.*}}'
@@ -0,0 +1,8 @@
+#include "templates.h"
+
+inline int useA() {
+  Box<int> I;
+  Box<Elem> E;
+  Box<char *> P;
+  return get(I) + get(E) + Size<Elem> + Size<char *> + sizeof(P);
+}
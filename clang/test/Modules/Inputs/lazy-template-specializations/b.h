@@ -0,0 +1,7 @@
+#include "templates.h"
+
+inline int useB() {
+  Box<Elem> E;
+  Box<long> L;
+  return get(E) + get(L) + Size<Elem> + Size<long>;
+}
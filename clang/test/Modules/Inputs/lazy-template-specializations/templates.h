@@ -0,0 +1,16 @@
+template <typename T> struct Box { T Value; };
+template <typename T> struct Box<T *> { T *Ptr; int Extra; };
+
+template <typename T> constexpr int Size = sizeof(T);
+template <typename T> constexpr int Size<T *> = -1;
+
+template <typename T> int get(const Box<T> &B) { return sizeof(B.Value); }
+
+struct Elem { char Data[3]; };
+
+// Only the lookups of Box<Unused> and get<Unused> load these, and with them
+// the declaration of Unused.
+struct Used {};
+struct Unused {};
+template <> struct Box<Unused> {};
+template <> int get(const Box<Unused> &B);
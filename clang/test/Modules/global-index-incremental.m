@@ -0,0 +1,46 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/Inputs
+// RUN: echo 'int a_decl(void);' > %t/Inputs/a.h
+// RUN: echo 'int b_decl(void);' > %t/Inputs/b.h
+// RUN: echo '#include "a.h"' > %t/Inputs/c.h
+// RUN: echo 'int c_decl(void);' >> %t/Inputs/c.h
+// RUN: echo 'module A { header "a.h" }' > %t/Inputs/module.map
+// RUN: echo 'module B { header "b.h" }' >> %t/Inputs/module.map
+// RUN: echo 'module C { header "c.h" export * }' >> %t/Inputs/module.map
+
+////
+// Build the modules and the global module index.
+// RUN: %clang_cc1 -I %t/Inputs -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/ModuleCache -fdisable-module-hash -fsyntax-only -verify %s
+// RUN: ls %t/ModuleCache | FileCheck --check-prefix=INDEX %s
+// INDEX: modules.idx
+// RUN: cp %t/ModuleCache/A.pcm %t/A.pcm.saved
+// RUN: cp %t/ModuleCache/C.pcm %t/C.pcm.saved
+// RUN: cp %t/ModuleCache/modules.idx %t/modules.idx.saved
+
+////
+// Change B. It is rebuilt, and the index is updated: A and C are carried over
+// from the previous index, and only B is read again.
+// RUN: echo 'int b_new(void);' >> %t/Inputs/b.h
+// RUN: %clang_cc1 -I %t/Inputs -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/ModuleCache -fdisable-module-hash -fsyntax-only -verify %s -DUSE_B_NEW
+// RUN: diff %t/ModuleCache/A.pcm %t/A.pcm.saved
+// RUN: diff %t/ModuleCache/C.pcm %t/C.pcm.saved
+// RUN: not diff %t/ModuleCache/modules.idx %t/modules.idx.saved
+
+////
+// Identifier lookups through the updated index find the declarations of both
+// the carried over and the reloaded modules.
+// RUN: %clang_cc1 -I %t/Inputs -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/ModuleCache -fdisable-module-hash -fsyntax-only -verify %s -DUSE_B_NEW -print-stats 2>&1 | FileCheck %s
+// CHECK: *** Global Module Index Statistics:
+// CHECK-NEXT: {{[1-9][0-9]*}} / {{[0-9]+}} identifier lookups succeeded
+
+// expected-no-diagnostics
+@import B;
+@import C;
+
+int test(void) {
+  return a_decl() + b_decl() + c_decl()
+#ifdef USE_B_NEW
+         + b_new()
+#endif
+      ;
+}
@@ -0,0 +1,35 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fmodules-cache-path=%t -fimplicit-module-maps -I%S/Inputs/lazy-template-specializations -std=c++14 -verify %s
+// RUN: %clang_cc1 -fmodules -fmodules-cache-path=%t -fimplicit-module-maps -I%S/Inputs/lazy-template-specializations -std=c++14 -verify %s -DUSED -error-on-deserialized-decl Unused
+// expected-no-diagnostics
+
+// Specializations are loaded from the modules by the hash of their template
+// arguments. Check that lookups still find the specializations instantiated
+// by any of the modules, that the ones instantiated by both are merged, and
+// that partial specializations are still considered.
+#include "a.h"
+#include "b.h"
+
+static_assert(sizeof(Box<Elem>) == 3, "");
+static_assert(sizeof(Box<int>) == sizeof(int), "");
+static_assert(sizeof(Box<long>) == sizeof(long), "");
+static_assert(sizeof(Box<char *>) == sizeof(Box<double *>), "");
+static_assert(sizeof(Box<short *>) > sizeof(short *), "");
+static_assert(Size<Elem> == 3, "");
+static_assert(Size<int *> == -1, "");
+static_assert(Size<char> == 1, "");
+
+int test() {
+  Box<Elem> E;
+  Box<long> L;
+  Box<unsigned> U;
+  return get(E) + get(L) + get(U) + useA() + useB();
+}
+
+#ifdef USED
+// Looking up the specializations for Used does not load the unrelated ones.
+int testUsed() {
+  Box<Used> B;
+  return get(B);
+}
+#endif
@@ -0,0 +1,35 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/Inputs
+// RUN: echo 'int foo(void);' > %t/Inputs/foo.h
+// RUN: echo 'module Foo { header "foo.h" }' > %t/Inputs/module.map
+
+////
+// Build the module.
+// RUN: %clang_cc1 -I %t/Inputs -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/ModuleCache -fdisable-module-hash -fsyntax-only %s
+// RUN: cp %t/ModuleCache/Foo.pcm %t/Foo.pcm.saved
+
+////
+// Modify the header. With -fmodules-lazy-validate-input-files, nothing from
+// it is needed here, so the module is not validated nor rebuilt.
+// RUN: echo ' ' >> %t/Inputs/foo.h
+// RUN: %clang_cc1 -I %t/Inputs -fmodules -fimplicit-module-maps -fmodules-lazy-validate-input-files -fmodules-cache-path=%t/ModuleCache -fdisable-module-hash -fsyntax-only %s
+// RUN: diff %t/ModuleCache/Foo.pcm %t/Foo.pcm.saved
+
+////
+// Without it, the module is rebuilt.
+// RUN: %clang_cc1 -I %t/Inputs -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/ModuleCache -fdisable-module-hash -fsyntax-only %s
+// RUN: not diff %t/ModuleCache/Foo.pcm %t/Foo.pcm.saved
+
+////
+// Change the declaration of foo. Using it deserializes its declaration, and
+// with it validates foo.h, even though no source location from foo.h is
+// otherwise needed.
+// RUN: echo 'int foo(int);' > %t/Inputs/foo.h
+// RUN: not %clang_cc1 -I %t/Inputs -fmodules -fimplicit-module-maps -fmodules-lazy-validate-input-files -fmodules-cache-path=%t/ModuleCache -fdisable-module-hash -fsyntax-only %s -DUSE_FOO 2>&1 | FileCheck %s
+// CHECK: error: file '{{.*}}foo.h' has been modified since the {{.*}} was built
+
+@import Foo;
+
+#ifdef USE_FOO
+int test(void) { return foo(); }
+#endif
@@ -0,0 +1,82 @@
+//===-- ClangScanDeps.cpp - Fast dependency scanning tool -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements a tool that writes the dependency files of all the
+//  translation units of a compilation database, running only the preprocessor
+//  over sources minimized down to their preprocessor directives.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/DependencyScanning.h"
+#include "clang/Tooling/JSONCompilationDatabase.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <thread>
+
+using namespace clang;
+using namespace clang::tooling;
+using namespace llvm;
+
+static cl::opt<std::string>
+    CompilationDB("compilation-database", cl::Required,
+                  cl::desc("The compilation database (compile_commands.json) "
+                           "listing the translation units to scan"));
+
+static cl::opt<unsigned>
+    NumThreads("j", cl::Optional,
+               cl::desc("The number of worker threads to use (default: use "
+                        "all concurrent threads)"),
+               cl::init(0));
+
+int main(int argc, const char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  cl::ParseCommandLineOptions(
+      argc, argv,
+      "Writes the dependency files of a compilation database, as requested by "
+      "the -M family of options of each command, without compiling "
+      "anything.\n");
+
+  std::string ErrorMessage;
+  std::unique_ptr<JSONCompilationDatabase> Compilations =
+      JSONCompilationDatabase::loadFromFile(CompilationDB, ErrorMessage,
+                                            JSONCommandLineSyntax::AutoDetect);
+  if (!Compilations) {
+    errs() << "error: " << ErrorMessage << "\n";
+    return 1;
+  }
+  const std::vector<CompileCommand> Commands =
+      Compilations->getAllCompileCommands();
+
+  unsigned Threads = NumThreads;
+  if (Threads == 0)
+    Threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  // Every thread owns a worker and pulls the next command to scan; all the
+  // workers share the cache of minimized files.
+  DependencyScanningFilesystemSharedCache SharedCache;
+  std::atomic<size_t> NextCommand(0);
+  std::atomic<bool> HadErrors(false);
+  ThreadPool Pool(Threads);
+  for (unsigned I = 0; I < Threads; ++I) {
+    Pool.async([&] {
+      DependencyScanningWorker Worker(SharedCache);
+      for (size_t Index = NextCommand++; Index < Commands.size();
+           Index = NextCommand++) {
+        const CompileCommand &Command = Commands[Index];
+        if (!Worker.runOnCommand(Command.CommandLine, Command.Directory))
+          HadErrors = true;
+      }
+    });
+  }
+  Pool.wait();
+  return HadErrors ? 1 : 0;
+}
@@ -32,8 +32,10 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
@@ -217,8 +219,41 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   if (!Success)
     return 1;
 
+  bool TimeTrace = Clang->getFrontendOpts().TimeTrace;
+  if (TimeTrace)
+    llvm::timeTraceProfilerInitialize(
+        Clang->getFrontendOpts().TimeTraceGranularity);
+
   // Execute the frontend actions.
-  Success = ExecuteCompilerInvocation(Clang.get());
+  {
+    llvm::TimeTraceScope TimeScope("ExecuteCompiler");
+    Success = ExecuteCompilerInvocation(Clang.get());
+  }
+
+  // Write the time trace to the file given by the driver, or next to the
+  // output file, or next to the input file when writing to stdout.
+  if (TimeTrace) {
+    const FrontendOptions &FEOpts = Clang->getFrontendOpts();
+    SmallString<128> Path(FEOpts.TimeTraceFile);
+    if (Path.empty()) {
+      Path = FEOpts.OutputFile;
+      if ((Path.empty() || Path == "-") && !FEOpts.Inputs.empty() &&
+          FEOpts.Inputs[0].isFile())
+        Path = llvm::sys::path::filename(FEOpts.Inputs[0].getFile());
+      if (!Path.empty() && Path != "-")
+        llvm::sys::path::replace_extension(Path, "json");
+    }
+    if (!Path.empty() && Path != "-") {
+      std::error_code EC;
+      llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_Text);
+      if (EC)
+        Clang->getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+            << Path << EC.message();
+      else
+        llvm::timeTraceProfilerWrite(OS);
+    }
+    llvm::timeTraceProfilerCleanup();
+  }
 
   // If any timers were active but haven't been destroyed yet, print their
   // results now.  This happens in -disable-free mode.
@@ -119,6 +119,54 @@ TEST(MatchFinder, CheckProfiling) {
   EXPECT_EQ("MyID", Records.begin()->getKey());
 }
 
+TEST(MatchFinder, CheckProfilingPerMatcher) {
+  MatchFinder::MatchFinderOptions Options;
+  llvm::StringMap<llvm::TimeRecord> Records;
+  llvm::StringMap<llvm::TimeRecord> MatcherRecords;
+  Options.CheckProfiling.emplace(Records);
+  Options.CheckProfiling->MatcherRecords = &MatcherRecords;
+  MatchFinder Finder(std::move(Options));
+
+  struct NamedCallback : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &Result) override {}
+    StringRef getID() const override { return "MyID"; }
+  } Callback;
+  Finder.addMatcher(varDecl(), &Callback);
+  Finder.addMatcher(varDecl(hasName("x")), &Callback);
+  Finder.addMatcher(callExpr(), &Callback);
+  std::unique_ptr<FrontendActionFactory> Factory(
+      newFrontendActionFactory(&Finder));
+  ASSERT_TRUE(tooling::runToolOnCode(Factory->create(), "int x;"));
+
+  EXPECT_EQ(1u, Records.size());
+  EXPECT_EQ("MyID", Records.begin()->getKey());
+  EXPECT_EQ(3u, MatcherRecords.size());
+  EXPECT_EQ(1u, MatcherRecords.count("MyID/VarDecl#0"));
+  EXPECT_EQ(1u, MatcherRecords.count("MyID/VarDecl#1"));
+  EXPECT_EQ(1u, MatcherRecords.count("MyID/CallExpr#0"));
+}
+
+TEST(MatchFinder, ReusesDispatchTableAcrossTranslationUnits) {
+  struct CountingCallback : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &Result) override { ++Count; }
+    unsigned Count = 0;
+  } VarCallback, FunctionCallback;
+
+  MatchFinder Finder;
+  Finder.addMatcher(varDecl(), &VarCallback);
+  std::unique_ptr<ASTUnit> AST(
+      tooling::buildASTFromCode("int x; void f() { int y; }"));
+  ASSERT_TRUE(AST.get());
+  Finder.matchAST(AST->getASTContext());
+  EXPECT_EQ(2u, VarCallback.Count);
+
+  // Adding a matcher must invalidate the cached per kind matcher lists.
+  Finder.addMatcher(functionDecl(), &FunctionCallback);
+  Finder.matchAST(AST->getASTContext());
+  EXPECT_EQ(4u, VarCallback.Count);
+  EXPECT_EQ(1u, FunctionCallback.Count);
+}
+
 class VerifyStartOfTranslationUnit : public MatchFinder::MatchCallback {
 public:
   VerifyStartOfTranslationUnit() : Called(false) {}
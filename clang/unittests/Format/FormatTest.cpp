@@ -13,6 +13,7 @@
 #include "FormatTestUtils.h"
 
 #include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "gtest/gtest.h"
@@ -3223,6 +3224,31 @@ TEST_F(FormatTest, MemoizationTests) {
   verifyFormat(input, OnePerLine);
 }
 
+TEST_F(FormatTest, CompletesLinesGreedilyAfterTooManyStates) {
+  std::string Code = "int a = fooooooooooooooo(aaaaaaaaaaaa, bbbbbbbbbbbbbbbbb, "
+                     "cccccccccccccc, dddddddddddddddd, eeeeeeeeee);";
+  verifyFormat("int a = fooooooooooooooo(\n"
+               "    aaaaaaaaaaaa, bbbbbbbbbbbbbbbbb,\n"
+               "    cccccccccccccc, dddddddddddddddd,\n"
+               "    eeeeeeeeee);",
+               getLLVMStyleWithColumns(40));
+
+  // Once the state budget is exhausted, the rest of the line is formatted by
+  // always taking the cheapest next step.
+  auto *MaxStates = static_cast<llvm::cl::opt<unsigned> *>(
+      llvm::cl::getRegisteredOptions()["format-max-states"]);
+  ASSERT_TRUE(MaxStates);
+  unsigned SavedMaxStates = *MaxStates;
+  *MaxStates = 5;
+  EXPECT_EQ("int a = fooooooooooooooo(aaaaaaaaaaaa,\n"
+            "                         bbbbbbbbbbbbbbbbb,\n"
+            "                         cccccccccccccc,\n"
+            "                         dddddddddddddddd,\n"
+            "                         eeeeeeeeee);",
+            format(Code, getLLVMStyleWithColumns(40)));
+  *MaxStates = SavedMaxStates;
+}
+
 TEST_F(FormatTest, BreaksAsHighAsPossible) {
   verifyFormat(
       "void f() {\n"
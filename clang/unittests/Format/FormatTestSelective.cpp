@@ -538,6 +538,74 @@ TEST_F(FormatTestSelective, KeepsIndentAfterCommentSectionImport) {
   EXPECT_EQ(Code, format(Code, 47, 1));
 }
 
+TEST_F(FormatTestSelective, OnlyLooksAtDeclarationsAroundRange) {
+  std::string Code = "int  a;\n"
+                     "void  f() {\n"
+                     "  int  x;\n"
+                     "  int  y;\n"
+                     "}\n"
+                     "\n"
+                     "// Comment.\n"
+                     "void  g() {\n"
+                     "  int  x ;\n" // This line starts at char 67.
+                     "  int  y;\n"
+                     "}\n"
+                     "\n"
+                     "void  h() {\n"
+                     "  int  x;\n"
+                     "  int  y;\n"
+                     "}\n"
+                     "int  b;";
+  EXPECT_EQ("int  a;\n"
+            "void  f() {\n"
+            "  int  x;\n"
+            "  int  y;\n"
+            "}\n"
+            "\n"
+            "// Comment.\n"
+            "void  g() {\n"
+            "  int x;\n"
+            "  int  y;\n"
+            "}\n"
+            "\n"
+            "void  h() {\n"
+            "  int  x;\n"
+            "  int  y;\n"
+            "}\n"
+            "int  b;",
+            format(Code, 67, 0));
+
+  // The lines following the range are still reindented up to the end of the
+  // enclosing declaration.
+  EXPECT_EQ("int  a;\n"
+            "\n"
+            "void f() {\n"
+            "  int x;\n"
+            "  int y;\n"
+            "}\n"
+            "\n"
+            "int  b;",
+            format("int  a;\n"
+                   "\n"
+                   "void f() {\n"
+                   "int x;\n"
+                   "    int y;\n"
+                   "}\n"
+                   "\n"
+                   "int  b;",
+                   20, 0));
+
+  // Trailing comments are aligned across lines that are not separated by an
+  // empty line.
+  EXPECT_EQ("int  a;\n"
+            "int b; // comment\n"
+            "int c; // comment",
+            format("int  a;\n"
+                   "int b;   // comment\n"
+                   "int c; // comment",
+                   8, 0));
+}
+
 } // end namespace
 } // end namespace format
 } // end namespace clang
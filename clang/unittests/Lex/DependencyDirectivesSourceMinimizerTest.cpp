@@ -0,0 +1,165 @@
+//===- unittests/Lex/DependencyDirectivesSourceMinimizerTest.cpp ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "llvm/ADT/SmallString.h"
+#include "gtest/gtest.h"
+
+using namespace clang;
+using namespace llvm;
+
+namespace {
+
+std::string minimize(StringRef Input) {
+  SmallString<128> Out;
+  EXPECT_FALSE(minimizeSourceToDependencyDirectives(Input, Out));
+  return Out.str();
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Empty) {
+  EXPECT_EQ("", minimize(""));
+  EXPECT_EQ("", minimize("int x;\n"));
+  EXPECT_EQ("", minimize("// #include <a>\n"));
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, KeepsDirectives) {
+  EXPECT_EQ("#include <a>\n"
+            "#include_next \"b\"\n"
+            "#import <c>\n"
+            "#__include_macros <d>\n"
+            "#define X 1\n"
+            "#undef X\n"
+            "#if X\n"
+            "#elif Y\n"
+            "#else\n"
+            "#endif\n"
+            "#ifdef X\n"
+            "#endif\n"
+            "#ifndef X\n"
+            "#endif\n",
+            minimize("#include <a>\n"
+                     "int x;\n"
+                     "#include_next \"b\"\n"
+                     "#import <c>\n"
+                     "#__include_macros <d>\n"
+                     "#define X 1\n"
+                     "#undef X\n"
+                     "#if X\n"
+                     "#elif Y\n"
+                     "#else\n"
+                     "#endif\n"
+                     "#ifdef X\n"
+                     "#endif\n"
+                     "#ifndef X\n"
+                     "#endif\n"));
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, DropsOtherDirectives) {
+  EXPECT_EQ("", minimize("#error don't\n"
+                         "#warning w\n"
+                         "#line 3\n"
+                         "# 4 \"file.c\"\n"
+                         "#ident \"x\"\n"
+                         "#\n"
+                         "#pragma GCC diagnostic push\n"));
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Pragmas) {
+  EXPECT_EQ("#pragma once\n"
+            "#pragma GCC system_header\n"
+            "#pragma clang system_header\n"
+            "#pragma push_macro(\"X\")\n"
+            "#pragma pop_macro(\"X\")\n"
+            "#pragma include_alias(<a>, \"b\")\n"
+            "#pragma clang module import A\n",
+            minimize("#pragma once\n"
+                     "#pragma GCC system_header\n"
+                     "#pragma clang system_header\n"
+                     "#pragma push_macro(\"X\")\n"
+                     "#pragma pop_macro(\"X\")\n"
+                     "#pragma include_alias(<a>, \"b\")\n"
+                     "#pragma clang module import A\n"
+                     "#pragma clang diagnostic ignored \"-Wall\"\n"));
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Whitespace) {
+  EXPECT_EQ("#include <a>\n"
+            "#define F(x) x + 1\n"
+            "#define G (x)\n",
+            minimize("  #  include<a>   \n"
+                     "\t#define F(x)   x  +\t1\n"
+                     "/* c */ # /* c */ define G (x) /* c */\n"));
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Comments) {
+  EXPECT_EQ("#define X 1\n"
+            "#define Y 2 3\n"
+            "#include \"a//b.h\"\n"
+            "#include <a//b.h>\n",
+            minimize("/*\n"
+                     "#include <a>\n"
+                     "*/\n"
+                     "// #include <b> \\\n"
+                     "#include <c>\n"
+                     "#define X 1 // x \\\n"
+                     "  continued comment\n"
+                     "#define Y 2 /* spanning\n"
+                     "lines */ 3\n"
+                     "#include \"a//b.h\"\n"
+                     "#include <a//b.h>\n"));
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, EscapedNewlines) {
+  EXPECT_EQ("#define X 1 + 2\n"
+            "#include <a>\n",
+            minimize("#define X 1 + \\\n"
+                     "  2\n"
+                     "int y = \\\n"
+                     "#include <ignored>\n"
+                     "#inc\\\n"
+                     "lude <a>\n"));
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Literals) {
+  EXPECT_EQ("#define S \"/* not a comment */\"\n"
+            "#include <a>\n"
+            "#if 'a' == 97\n"
+            "#endif\n",
+            minimize("const char *s = \"/*\";\n"
+                     "char c = '\"';\n"
+                     "int n = 1'000; /*\n"
+                     "#include <ignored>\n"
+                     "*/\n"
+                     "const char *r = R\"x(\n"
+                     "#include <ignored>\n"
+                     ")\" )x\";\n"
+                     "const char *u = u8R\"(\n"
+                     "#include <ignored>\n"
+                     ")\";\n"
+                     "#define S \"/* not a comment */\"\n"
+                     "#include <a>\n"
+                     "#if 'a' == 97\n"
+                     "#endif\n"));
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, AtImportAndDigraphs) {
+  EXPECT_EQ("@import A.B;\n"
+            "#include <a>\n",
+            minimize("@import A.B;\n"
+                     "@importFoo;\n"
+                     "%:include <a>\n"));
+}
+
+TEST(MinimizeSourceToDependencyDirectivesTest, Errors) {
+  SmallString<128> Out;
+  EXPECT_TRUE(minimizeSourceToDependencyDirectives("/* unterminated", Out));
+  EXPECT_TRUE(minimizeSourceToDependencyDirectives("R\"(unterminated", Out));
+}
+
+} // end anonymous namespace
@@ -0,0 +1,209 @@
+//===- unittests/Lex/HeaderLookupCacheTest.cpp - HeaderLookupCache tests --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/HeaderLookupCache.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemOptions.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <unistd.h>
+
+using namespace clang;
+using namespace llvm;
+
+namespace {
+
+class HeaderLookupCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_FALSE(sys::fs::createUniqueDirectory("header-lookup-cache", Root));
+    CachePath = Root;
+    sys::path::append(CachePath, "lookup.cache");
+    IncludeDir = Root;
+    sys::path::append(IncludeDir, "include");
+    ASSERT_FALSE(sys::fs::create_directory(IncludeDir));
+    addFile("include/Foo.h");
+    addDirectory("include/sys");
+    addFile("include/sys/types.h");
+  }
+
+  void TearDown() override { sys::fs::remove_directories(Root); }
+
+  void addDirectory(StringRef RelPath) {
+    SmallString<128> Path(Root);
+    sys::path::append(Path, RelPath);
+    ASSERT_FALSE(sys::fs::create_directory(Path));
+  }
+
+  void addFile(StringRef RelPath) {
+    SmallString<128> Path(Root);
+    sys::path::append(Path, RelPath);
+    std::error_code EC;
+    raw_fd_ostream Out(Path, EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+  }
+
+  /// Pretend \p RelPath was last modified \p SecondsAgo seconds ago, so that
+  /// its listing is old enough to be persisted.
+  void setAge(StringRef RelPath, unsigned SecondsAgo) {
+    SmallString<128> Path(Root);
+    sys::path::append(Path, RelPath);
+    int FD;
+    ASSERT_FALSE(sys::fs::openFileForRead(Path, FD));
+    EXPECT_FALSE(sys::fs::setLastModificationAndAccessTime(
+        FD, std::chrono::system_clock::now() -
+                std::chrono::seconds(SecondsAgo)));
+    ::close(FD);
+  }
+
+  /// Starts a new compilation run from \p WorkingDir, relative to the root,
+  /// and returns its file manager.
+  FileManager &newCompilation(StringRef WorkingDir = "") {
+    FileSystemOptions Opts;
+    if (!WorkingDir.empty()) {
+      SmallString<128> Path(Root);
+      sys::path::append(Path, WorkingDir);
+      Opts.WorkingDir = Path.str();
+    }
+    FileMgrs.push_back(llvm::make_unique<FileManager>(Opts));
+    return *FileMgrs.back();
+  }
+
+  SmallString<128> Root;
+  SmallString<128> CachePath;
+  SmallString<128> IncludeDir;
+  std::vector<std::unique_ptr<FileManager>> FileMgrs;
+};
+
+TEST_F(HeaderLookupCacheTest, RejectsMissingFiles) {
+  FileManager &FileMgr = newCompilation();
+  const DirectoryEntry *Dir = FileMgr.getDirectory(IncludeDir);
+  ASSERT_TRUE(Dir);
+  HeaderLookupCache Cache(CachePath, FileMgr);
+  EXPECT_TRUE(Cache.mayContainFile(Dir, "Foo.h"));
+  EXPECT_TRUE(Cache.mayContainFile(Dir, "foo.H"));
+  EXPECT_TRUE(Cache.mayContainFile(Dir, "sys/types.h"));
+  EXPECT_FALSE(Cache.mayContainFile(Dir, "Bar.h"));
+  EXPECT_FALSE(Cache.mayContainFile(Dir, "sys/stat.h"));
+  EXPECT_FALSE(Cache.mayContainFile(Dir, "linux/types.h"));
+
+  // The cache does not reason about these.
+  EXPECT_TRUE(Cache.mayContainFile(Dir, "../include/Bar.h"));
+  EXPECT_TRUE(Cache.mayContainFile(Dir, "./Bar.h"));
+}
+
+TEST_F(HeaderLookupCacheTest, RecentListingsAreNotPersisted) {
+  {
+    FileManager &FileMgr = newCompilation();
+    HeaderLookupCache Cache(CachePath, FileMgr);
+    EXPECT_FALSE(
+        Cache.mayContainFile(FileMgr.getDirectory(IncludeDir), "Bar.h"));
+    Cache.write();
+  }
+  EXPECT_FALSE(sys::fs::exists(CachePath));
+}
+
+TEST_F(HeaderLookupCacheTest, ReusesListingsAcrossCompilations) {
+  setAge("include", 60);
+  setAge("include/sys", 60);
+  {
+    FileManager &FileMgr = newCompilation();
+    HeaderLookupCache Cache(CachePath, FileMgr);
+    EXPECT_FALSE(
+        Cache.mayContainFile(FileMgr.getDirectory(IncludeDir), "sys/stat.h"));
+    Cache.write();
+  }
+  ASSERT_TRUE(sys::fs::exists(CachePath));
+
+  {
+    FileManager &FileMgr = newCompilation();
+    const DirectoryEntry *Dir = FileMgr.getDirectory(IncludeDir);
+    HeaderLookupCache Cache(CachePath, FileMgr);
+    EXPECT_TRUE(Cache.mayContainFile(Dir, "Foo.h"));
+    EXPECT_TRUE(Cache.mayContainFile(Dir, "sys/types.h"));
+    EXPECT_FALSE(Cache.mayContainFile(Dir, "sys/stat.h"));
+  }
+
+  // A listing is no longer trusted once its directory is modified.
+  addFile("include/sys/stat.h");
+  setAge("include/sys", 30);
+  {
+    FileManager &FileMgr = newCompilation();
+    const DirectoryEntry *Dir = FileMgr.getDirectory(IncludeDir);
+    HeaderLookupCache Cache(CachePath, FileMgr);
+    EXPECT_TRUE(Cache.mayContainFile(Dir, "sys/stat.h"));
+    EXPECT_FALSE(Cache.mayContainFile(Dir, "sys/wait.h"));
+  }
+}
+
+TEST_F(HeaderLookupCacheTest, KeysRelativeDirectoriesByRealPath) {
+  // Two projects with the same relative include directory, "-I include",
+  // but different headers in it.
+  addDirectory("a");
+  addDirectory("a/include");
+  addFile("a/include/A.h");
+  addDirectory("b");
+  addDirectory("b/include");
+  addFile("b/include/B.h");
+  setAge("a/include", 60);
+  setAge("b/include", 60);
+
+  {
+    FileManager &FileMgr = newCompilation("a");
+    const DirectoryEntry *Dir = FileMgr.getDirectory("include");
+    ASSERT_TRUE(Dir);
+    HeaderLookupCache Cache(CachePath, FileMgr);
+    EXPECT_TRUE(Cache.mayContainFile(Dir, "A.h"));
+    EXPECT_FALSE(Cache.mayContainFile(Dir, "B.h"));
+    Cache.write();
+  }
+  ASSERT_TRUE(sys::fs::exists(CachePath));
+
+  // The listing of a/include does not answer for b/include.
+  {
+    FileManager &FileMgr = newCompilation("b");
+    const DirectoryEntry *Dir = FileMgr.getDirectory("include");
+    ASSERT_TRUE(Dir);
+    HeaderLookupCache Cache(CachePath, FileMgr);
+    EXPECT_TRUE(Cache.mayContainFile(Dir, "B.h"));
+    EXPECT_FALSE(Cache.mayContainFile(Dir, "A.h"));
+    Cache.write();
+  }
+
+  // Both listings are kept, and found again from either project.
+  {
+    FileManager &FileMgr = newCompilation("a");
+    const DirectoryEntry *Dir = FileMgr.getDirectory("include");
+    HeaderLookupCache Cache(CachePath, FileMgr);
+    EXPECT_TRUE(Cache.mayContainFile(Dir, "A.h"));
+    EXPECT_FALSE(Cache.mayContainFile(Dir, "B.h"));
+  }
+}
+
+TEST_F(HeaderLookupCacheTest, IgnoresInvalidCacheFiles) {
+  {
+    std::error_code EC;
+    raw_fd_ostream Out(CachePath, EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    Out << "not a header lookup cache";
+  }
+  setAge("include", 60);
+  FileManager &FileMgr = newCompilation();
+  const DirectoryEntry *Dir = FileMgr.getDirectory(IncludeDir);
+  HeaderLookupCache Cache(CachePath, FileMgr);
+  EXPECT_TRUE(Cache.mayContainFile(Dir, "Foo.h"));
+  EXPECT_FALSE(Cache.mayContainFile(Dir, "Bar.h"));
+  Cache.write();
+}
+
+} // anonymous namespace
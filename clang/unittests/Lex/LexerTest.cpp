@@ -420,4 +420,35 @@ TEST_F(LexerTest, DontOverallocateStringifyArgs) {
 #endif
 }
 
+TEST_F(LexerTest, SkipsExcludedBlocksAndLongTokens) {
+  LangOpts.CPlusPlus = true;
+  LangOpts.CPlusPlus11 = true;
+  LangOpts.LineComment = true;
+
+  std::vector<tok::TokenKind> ExpectedTokens;
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::string_literal);
+  ExpectedTokens.push_back(tok::semi);
+
+  // The '#endif's in the comment and in the raw string literal must not end
+  // the excluded block.
+  std::vector<Token> toks = CheckLex(
+      "#if 0\n"
+      "x = y; /*\n"
+      "#endif\n"
+      "*/ z = R\"(\n"
+      "#endif\n"
+      ")\";\n"
+      "#else\n"
+      "identifier_longer_than_sixteen_bytes "
+      "\"string literal longer than sixteen bytes\" "
+      "// line comment longer than sixteen bytes\n"
+      ";\n"
+      "#endif\n",
+      ExpectedTokens);
+
+  EXPECT_EQ(36u, toks[0].getLength());
+  EXPECT_EQ(42u, toks[1].getLength());
+}
+
 } // anonymous namespace
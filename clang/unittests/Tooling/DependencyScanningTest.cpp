@@ -0,0 +1,98 @@
+//===- unittest/Tooling/DependencyScanningTest.cpp ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/DependencyScanning.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "gtest/gtest.h"
+
+using namespace clang;
+using namespace tooling;
+
+namespace {
+
+IntrusiveRefCntPtr<vfs::InMemoryFileSystem> createFS() {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> FS(
+      new vfs::InMemoryFileSystem);
+  FS->setCurrentWorkingDirectory("/root");
+  FS->addFile("/root/main.c", 0,
+              llvm::MemoryBuffer::getMemBuffer("#include \"a.h\" // a\n"
+                                               "int main() { return 0; }\n"));
+  FS->addFile("/root/module.modulemap", 0,
+              llvm::MemoryBuffer::getMemBuffer("module A { header \"a.h\" }\n"));
+  FS->addFile("/root/bad.h", 0,
+              llvm::MemoryBuffer::getMemBuffer("int x; /* unterminated"));
+  return FS;
+}
+
+std::string getContents(vfs::FileSystem &FS, StringRef Path) {
+  auto Buffer = FS.getBufferForFile(Path);
+  if (!Buffer)
+    return "<error>";
+  return (*Buffer)->getBuffer();
+}
+
+TEST(DependencyScanningFilesystem, MinimizesSources) {
+  DependencyScanningFilesystemSharedCache SharedCache;
+  IntrusiveRefCntPtr<DependencyScanningFilesystem> DepFS(
+      new DependencyScanningFilesystem(SharedCache, createFS()));
+
+  EXPECT_EQ("#include \"a.h\"\n", getContents(*DepFS, "/root/main.c"));
+  auto Stat = DepFS->status("/root/main.c");
+  ASSERT_TRUE(bool(Stat));
+  EXPECT_EQ(15u, Stat->getSize());
+  EXPECT_EQ("/root/main.c", Stat->getName());
+
+  // Module maps are not minimized, and neither are the files the minimizer
+  // cannot handle.
+  EXPECT_EQ("module A { header \"a.h\" }\n",
+            getContents(*DepFS, "/root/module.modulemap"));
+  EXPECT_EQ("int x; /* unterminated", getContents(*DepFS, "/root/bad.h"));
+
+  EXPECT_FALSE(DepFS->status("/root/missing.h"));
+  EXPECT_TRUE(DepFS->status("/root")->isDirectory());
+  EXPECT_FALSE(DepFS->openFileForRead("/root"));
+}
+
+TEST(DependencyScanningFilesystem, SharesCachedEntries) {
+  DependencyScanningFilesystemSharedCache SharedCache;
+  IntrusiveRefCntPtr<DependencyScanningFilesystem> DepFS1(
+      new DependencyScanningFilesystem(SharedCache, createFS()));
+  EXPECT_TRUE(DepFS1->exists("/root/main.c"));
+  EXPECT_FALSE(DepFS1->exists("/root/missing.h"));
+
+  // The second file system never reads its own, empty, underlying file
+  // system for the entries that are already in the shared cache, including
+  // the negative ones.
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> Other(
+      new vfs::InMemoryFileSystem);
+  Other->addFile("/root/missing.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  IntrusiveRefCntPtr<DependencyScanningFilesystem> DepFS2(
+      new DependencyScanningFilesystem(SharedCache, Other));
+  EXPECT_EQ("#include \"a.h\"\n", getContents(*DepFS2, "/root/main.c"));
+  EXPECT_FALSE(DepFS2->exists("/root/missing.h"));
+  EXPECT_FALSE(DepFS2->exists("/root/bad.h"));
+}
+
+TEST(DependencyScanningFilesystem, TracksItsOwnWorkingDirectory) {
+  DependencyScanningFilesystemSharedCache SharedCache;
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> FS = createFS();
+  IntrusiveRefCntPtr<DependencyScanningFilesystem> DepFS(
+      new DependencyScanningFilesystem(SharedCache, FS));
+
+  EXPECT_EQ("/root", *DepFS->getCurrentWorkingDirectory());
+  EXPECT_FALSE(DepFS->setCurrentWorkingDirectory("/other"));
+  EXPECT_EQ("/other", *DepFS->getCurrentWorkingDirectory());
+  EXPECT_EQ("/root", *FS->getCurrentWorkingDirectory());
+
+  EXPECT_FALSE(DepFS->exists("main.c"));
+  EXPECT_FALSE(DepFS->setCurrentWorkingDirectory("/root"));
+  EXPECT_EQ("#include \"a.h\"\n", getContents(*DepFS, "main.c"));
+}
+
+} // end anonymous namespace
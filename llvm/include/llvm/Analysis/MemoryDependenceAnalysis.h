@@ -348,11 +348,15 @@ private:
   DominatorTree &DT;
   PredIteratorCache PredCache;
 
+  /// The number of blocks visited so far by non-local pointer queries,
+  /// checked against -memdep-nonlocal-block-budget.
+  unsigned NumNonLocalPtrBlocks;
+
 public:
   MemoryDependenceResults(AliasAnalysis &AA, AssumptionCache &AC,
                           const TargetLibraryInfo &TLI,
                           DominatorTree &DT)
-      : AA(AA), AC(AC), TLI(TLI), DT(DT) {}
+      : AA(AA), AC(AC), TLI(TLI), DT(DT), NumNonLocalPtrBlocks(0) {}
 
   /// Handle invalidation in the new PM.
   bool invalidate(Function &F, const PreservedAnalyses &PA,
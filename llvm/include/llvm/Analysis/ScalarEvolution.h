@@ -543,6 +543,15 @@ private:
   /// predicate by splitting it into a set of independent predicates.
   bool ProvingSplitPredicate;
 
+  /// The number of values and exit conditions analyzed so far, which is
+  /// checked against -scalar-evolution-max-work.
+  unsigned WorkDone;
+
+  /// Account for analyzing one more value or exit condition. Returns false
+  /// once the work budget of the function is exhausted, in which case the
+  /// caller must fall back to a conservative answer.
+  bool consumeWork();
+
   /// Memoized values for the GetMinTrailingZeros
   DenseMap<const SCEV *, uint32_t> MinTrailingZerosCache;
 
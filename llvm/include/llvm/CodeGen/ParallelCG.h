@@ -22,10 +22,15 @@
 namespace llvm {
 
 template <typename T> class ArrayRef;
+class LLVMContext;
 class Module;
 class TargetOptions;
 class raw_pwrite_stream;
 
+namespace legacy {
+class PassManagerBase;
+}
+
 /// Split M into OSs.size() partitions, and generate code for each. Takes a
 /// factory function for the TargetMachine TMFactory. Writes OSs.size() output
 /// files to the output streams in OSs. The resulting output files if linked
@@ -35,13 +40,21 @@ class raw_pwrite_stream;
 /// Writes bitcode for individual partitions into output streams in BCOSs, if
 /// BCOSs is not empty.
 ///
+/// If given, PartitionSetup is called, on the thread that code generates the
+/// partition, with the context of the partition and its code generation pass
+/// manager before the passes of the target are added. This is where the
+/// caller installs a diagnostic handler or adds a TargetLibraryInfo of its own,
+/// since each partition is code generated in a new context.
+///
 /// \returns M if OSs.size() == 1, otherwise returns std::unique_ptr<Module>().
 std::unique_ptr<Module>
 splitCodeGen(std::unique_ptr<Module> M, ArrayRef<raw_pwrite_stream *> OSs,
              ArrayRef<llvm::raw_pwrite_stream *> BCOSs,
              const std::function<std::unique_ptr<TargetMachine>()> &TMFactory,
              TargetMachine::CodeGenFileType FT = TargetMachine::CGFT_ObjectFile,
-             bool PreserveLocals = false);
+             bool PreserveLocals = false,
+             const std::function<void(LLVMContext &, legacy::PassManagerBase &)>
+                 &PartitionSetup = nullptr);
 
 } // namespace llvm
 
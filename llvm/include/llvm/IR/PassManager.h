@@ -1180,6 +1180,12 @@ using ModuleAnalysisManagerFunctionProxy =
 /// Note that although function passes can access module analyses, module
 /// analyses are not invalidated while the function passes are running, so they
 /// may be stale.  Function analyses will not be stale.
+///
+/// FIXME: Functions are visited sequentially. Running the pipelines of
+/// independent functions concurrently additionally requires the use lists of
+/// constants and globals, the uniquing tables of the LLVMContext, and the
+/// result caches of the FunctionAnalysisManager to be safe to update from
+/// several threads, which they are not.
 template <typename FunctionPassT>
 class ModuleToFunctionPassAdaptor
     : public PassInfoMixin<ModuleToFunctionPassAdaptor<FunctionPassT>> {
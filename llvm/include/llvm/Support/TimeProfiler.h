@@ -0,0 +1,113 @@
+//===- llvm/Support/TimeProfiler.h - Hierarchical Time Profiler -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a profiler that records nested time spans, such as the
+// parsing of a header or the instantiation of a template, and writes them in
+// the Chrome trace event format, which can be viewed in chrome://tracing.
+//
+// The profiler is disabled unless timeTraceProfilerInitialize() is called, and
+// a disabled TimeTraceScope only costs a test of a thread-local pointer, so
+// scopes can be placed on hot paths.
+//
+// Each thread records into its own profiler. A thread other than the one that
+// writes the trace calls timeTraceProfilerInitialize() when it starts and
+// timeTraceProfilerFinishThread() when it is done, and its sections are then
+// written on their own row of the trace.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_TIMEPROFILER_H
+#define LLVM_SUPPORT_TIMEPROFILER_H
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compiler.h"
+#include <string>
+
+namespace llvm {
+
+class raw_ostream;
+struct TimeTraceProfiler;
+
+extern LLVM_THREAD_LOCAL TimeTraceProfiler *TimeTraceProfilerInstance;
+
+/// Initialize the time trace profiler of the calling thread. This sets up the
+/// thread-local \c TimeTraceProfilerInstance variable to be the profiler
+/// instance. Only the sections that last at least \p TimeTraceGranularity
+/// microseconds are written to the trace; all of them count toward the totals.
+void timeTraceProfilerInitialize(unsigned TimeTraceGranularity = 500);
+
+/// The granularity the profiler of the calling thread was initialized with.
+unsigned timeTraceProfilerGranularity();
+
+/// Hand the profile of the calling thread over to the thread that writes the
+/// trace, and disable the profiler in the calling thread.
+void timeTraceProfilerFinishThread();
+
+/// Cleanup the time trace profiler of the calling thread, if it was
+/// initialized, and the profiles handed over by the other threads.
+void timeTraceProfilerCleanup();
+
+/// Is the time trace profiler enabled in the calling thread, i.e. initialized?
+inline bool timeTraceProfilerEnabled() {
+  return TimeTraceProfilerInstance != nullptr;
+}
+
+/// Write the profiling result of the calling thread, and of the threads that
+/// finished, to the output stream. Events that are still in progress are not
+/// written.
+void timeTraceProfilerWrite(raw_ostream &OS);
+
+/// Manually begin a time section, with the given \p Name and \p Detail.
+/// Profiler copies the string data, so the pointers can be given into
+/// temporaries. Time sections can be hierarchical; every Begin must have a
+/// matching End pair but they can nest.
+void timeTraceProfilerBegin(StringRef Name, StringRef Detail);
+void timeTraceProfilerBegin(StringRef Name, const char *Detail);
+void timeTraceProfilerBegin(StringRef Name,
+                            function_ref<std::string()> Detail);
+
+/// Manually end the last time section.
+void timeTraceProfilerEnd();
+
+/// The TimeTraceScope is a helper class to call the begin and end functions
+/// of the time trace profiler. When the object is constructed, it begins the
+/// section; and when it is destroyed, it stops it. If the time profiler is not
+/// initialized, the overhead is a single branch.
+///
+/// The detail can be given as a callback, which is only called when the
+/// profiler is enabled, to avoid computing e.g. the name of a declaration when
+/// it is not needed.
+struct TimeTraceScope {
+  TimeTraceScope() = delete;
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  TimeTraceScope &operator=(const TimeTraceScope &) = delete;
+
+  TimeTraceScope(StringRef Name, StringRef Detail = StringRef()) {
+    if (TimeTraceProfilerInstance != nullptr)
+      timeTraceProfilerBegin(Name, Detail);
+  }
+  // A string literal converts to both StringRef and function_ref.
+  TimeTraceScope(StringRef Name, const char *Detail) {
+    if (TimeTraceProfilerInstance != nullptr)
+      timeTraceProfilerBegin(Name, StringRef(Detail));
+  }
+  TimeTraceScope(StringRef Name, function_ref<std::string()> Detail) {
+    if (TimeTraceProfilerInstance != nullptr)
+      timeTraceProfilerBegin(Name, Detail);
+  }
+  ~TimeTraceScope() {
+    if (TimeTraceProfilerInstance != nullptr)
+      timeTraceProfilerEnd();
+  }
+};
+
+} // end namespace llvm
+
+#endif
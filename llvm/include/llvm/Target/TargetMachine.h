@@ -283,6 +283,12 @@ public:
 
   /// Add passes to the specified pass manager to get the specified file
   /// emitted.  Typically this will involve several steps of code generation.
+  ///
+  /// FIXME: The machine function passes run on one function at a time. They
+  /// cannot overlap across functions yet: instruction selection creates IR
+  /// constants in the shared LLVMContext, subtargets are created lazily and
+  /// cached on the TargetMachine, and symbols are created in the module's
+  /// MCContext. Use splitCodeGen to generate code for a module in parallel.
   bool addPassesToEmitFile(
       PassManagerBase &PM, raw_pwrite_stream &Out, CodeGenFileType FileType,
       bool DisableVerify = true, AnalysisID StartBefore = nullptr,
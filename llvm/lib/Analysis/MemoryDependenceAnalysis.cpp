@@ -75,6 +75,15 @@ static cl::opt<unsigned>
                      cl::desc("The number of blocks to scan during memory "
                               "dependency analysis (default = 1000)"));
 
+// Limit on the total number of blocks visited by the non-local pointer queries
+// of one function, so that large functions with many loads don't scale
+// quadratically. Queries that exceed it return a conservative result.
+static cl::opt<unsigned> NonLocalBlockBudget(
+    "memdep-nonlocal-block-budget", cl::Hidden, cl::init(100000),
+    cl::desc("The number of blocks that the non-local pointer queries of a "
+             "function may visit in memory dependency analysis "
+             "(default = 100000)"));
+
 // Limit on the number of memdep results to process.
 static const unsigned int NumResultsLimit = 100;
 
@@ -1279,7 +1288,8 @@ bool MemoryDependenceResults::getNonLocalPointerDepFromBB(
           goto PredTranslationFailure;
         }
       }
-      if (NewBlocks.size() > WorklistEntries) {
+      if (NewBlocks.size() > WorklistEntries ||
+          NewBlocks.size() > NonLocalBlockBudget - NumNonLocalPtrBlocks) {
         // Make sure to clean up the Visited map before continuing on to
         // PredTranslationFailure.
         for (unsigned i = 0; i < NewBlocks.size(); i++)
@@ -1288,6 +1298,7 @@ bool MemoryDependenceResults::getNonLocalPointerDepFromBB(
         goto PredTranslationFailure;
       }
       WorklistEntries -= NewBlocks.size();
+      NumNonLocalPtrBlocks += NewBlocks.size();
       Worklist.append(NewBlocks.begin(), NewBlocks.end());
       continue;
     }
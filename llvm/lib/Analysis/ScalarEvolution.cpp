@@ -92,6 +92,7 @@
 #include "llvm/Support/KnownBits.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 using namespace llvm;
@@ -106,6 +107,16 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumValueExprMapHits, "Number of SCEVs found in ValueExprMap");
+STATISTIC(NumValueExprMapMisses, "Number of SCEVs not found in ValueExprMap");
+STATISTIC(NumBackedgeTakenCountHits,
+          "Number of backedge-taken counts found in the cache");
+STATISTIC(NumBackedgeTakenCountMisses,
+          "Number of backedge-taken counts not found in the cache");
+STATISTIC(MaxSCEVNAryOperands,
+          "Maximum number of operands of an n-ary SCEV created for a value");
+STATISTIC(NumWorkBudgetExhausted,
+          "Number of functions that exhausted the SCEV work budget");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -162,6 +173,12 @@ static cl::opt<unsigned>
                 cl::desc("Maximum depth of recursive SExt/ZExt"),
                 cl::init(8));
 
+static cl::opt<unsigned> MaxWork(
+    "scalar-evolution-max-work", cl::Hidden,
+    cl::desc("Maximum number of values and exit conditions that SCEV analyzes "
+             "in a function before it stops trying (0 = unlimited)"),
+    cl::init(1000000));
+
 //===----------------------------------------------------------------------===//
 //                           SCEV class definitions
 //===----------------------------------------------------------------------===//
@@ -3660,8 +3677,13 @@ const SCEV *ScalarEvolution::getSCEV(Value *V) {
   assert(isSCEVable(V->getType()) && "Value is not SCEVable!");
 
   const SCEV *S = getExistingSCEV(V);
-  if (S == nullptr) {
+  if (S) {
+    ++NumValueExprMapHits;
+  } else {
+    ++NumValueExprMapMisses;
     S = createSCEV(V);
+    if (const SCEVNAryExpr *NAry = dyn_cast<SCEVNAryExpr>(S))
+      MaxSCEVNAryOperands.updateMax(NAry->getNumOperands());
     // During PHI resolution, it is possible to create two SCEVs for the same
     // V, so it is needed to double check whether V->S is inserted into
     // ValueExprMap before insert S->{V, 0} into ExprValueMap.
@@ -5318,6 +5340,9 @@ const SCEV *ScalarEvolution::createSCEV(Value *V) {
     // analysis depends on.
     if (!DT.isReachableFromEntry(I->getParent()))
       return getUnknown(V);
+    // Once the work budget is exhausted, treat the instruction as opaque.
+    if (!consumeWork())
+      return getUnknown(V);
   } else if (ConstantInt *CI = dyn_cast<ConstantInt>(V))
     return getConstant(CI);
   else if (isa<ConstantPointerNull>(V))
@@ -5806,7 +5831,7 @@ ScalarEvolution::getPredicatedBackedgeTakenInfo(const Loop *L) {
 
   auto Pair = PredicatedBackedgeTakenCounts.insert({L, BackedgeTakenInfo()});
 
-  if (!Pair.second)
+  if (!Pair.second || !consumeWork())
     return Pair.first->second;
 
   BackedgeTakenInfo Result =
@@ -5824,9 +5849,20 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
   // backedge-taken count, which could result in infinite recursion.
   std::pair<DenseMap<const Loop *, BackedgeTakenInfo>::iterator, bool> Pair =
       BackedgeTakenCounts.insert({L, BackedgeTakenInfo()});
-  if (!Pair.second)
+  if (!Pair.second) {
+    ++NumBackedgeTakenCountHits;
+    return Pair.first->second;
+  }
+  ++NumBackedgeTakenCountMisses;
+
+  // Once the work budget is exhausted, leave the count as CouldNotCompute.
+  if (!consumeWork())
     return Pair.first->second;
 
+  TimeTraceScope TimeScope("ComputeBackedgeTakenCount", [&]() {
+    return L->getHeader()->getName().str();
+  });
+
   // computeBackedgeTakenCount may allocate memory for its result. Inserting it
   // into the BackedgeTakenCounts map transfers ownership. Otherwise, the result
   // must be cleared in this scope.
@@ -7566,6 +7602,9 @@ ScalarEvolution::howFarToZero(const SCEV *V, const Loop *L, bool ControlsExit,
     return getCouldNotCompute();  // Otherwise it will loop infinitely.
   }
 
+  if (!consumeWork())
+    return getCouldNotCompute();
+
   const SCEVAddRecExpr *AddRec = dyn_cast<SCEVAddRecExpr>(V);
   if (!AddRec && AllowPredicates)
     // Try to make this an AddRec using runtime tests, in the first X
@@ -10017,14 +10056,28 @@ ScalarEvolution::SCEVCallbackVH::SCEVCallbackVH(Value *V, ScalarEvolution *se)
 //                   ScalarEvolution Class Implementation
 //===----------------------------------------------------------------------===//
 
+bool ScalarEvolution::consumeWork() {
+  if (MaxWork == 0 || WorkDone < MaxWork) {
+    ++WorkDone;
+    return true;
+  }
+  if (WorkDone == MaxWork) {
+    // Count each function once.
+    ++NumWorkBudgetExhausted;
+    ++WorkDone;
+    DEBUG(dbgs() << "SCEV: work budget exhausted in " << F.getName() << "\n");
+  }
+  return false;
+}
+
 ScalarEvolution::ScalarEvolution(Function &F, TargetLibraryInfo &TLI,
                                  AssumptionCache &AC, DominatorTree &DT,
                                  LoopInfo &LI)
     : F(F), TLI(TLI), AC(AC), DT(DT), LI(LI),
       CouldNotCompute(new SCEVCouldNotCompute()),
       WalkingBEDominatingConds(false), ProvingSplitPredicate(false),
-      ValuesAtScopes(64), LoopDispositions(64), BlockDispositions(64),
-      FirstUnknown(nullptr) {
+      WorkDone(0), ValuesAtScopes(64), LoopDispositions(64),
+      BlockDispositions(64), FirstUnknown(nullptr) {
 
   // To use guards for proving predicates, we need to scan every instruction in
   // relevant basic blocks, and not just terminators.  Doing this is a waste of
@@ -10047,6 +10100,7 @@ ScalarEvolution::ScalarEvolution(ScalarEvolution &&Arg)
       ValueExprMap(std::move(Arg.ValueExprMap)),
       PendingLoopPredicates(std::move(Arg.PendingLoopPredicates)),
       WalkingBEDominatingConds(false), ProvingSplitPredicate(false),
+      WorkDone(Arg.WorkDone),
       MinTrailingZerosCache(std::move(Arg.MinTrailingZerosCache)),
       BackedgeTakenCounts(std::move(Arg.BackedgeTakenCounts)),
       PredicatedBackedgeTakenCounts(
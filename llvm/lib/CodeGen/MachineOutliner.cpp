@@ -42,6 +42,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
@@ -49,6 +50,7 @@
 #include "llvm/CodeGen/Passes.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
@@ -67,6 +69,15 @@ using namespace llvm;
 
 STATISTIC(NumOutlined, "Number of candidates outlined");
 STATISTIC(FunctionsCreated, "Number of functions created");
+STATISTIC(NumHotFunctionsSkipped,
+          "Number of functions not outlined from because they are hot");
+
+// Calls to outlined functions cost a call and a return at run time, so by
+// default only outline from functions that the profile doesn't mark as hot.
+static cl::opt<bool> OutlineFromHotFunctions(
+    "outliner-outline-hot-functions", cl::Hidden, cl::init(false),
+    cl::desc("Outline from functions whose entry is hot according to the "
+             "profile summary"));
 
 namespace {
 
@@ -828,6 +839,7 @@ struct MachineOutliner : public ModulePass {
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.addRequired<MachineModuleInfo>();
     AU.addPreserved<MachineModuleInfo>();
+    AU.addRequired<ProfileSummaryInfoWrapperPass>();
     AU.setPreservesAll();
     ModulePass::getAnalysisUsage(AU);
   }
@@ -901,8 +913,11 @@ namespace llvm {
 ModulePass *createMachineOutlinerPass() { return new MachineOutliner(); }
 }
 
-INITIALIZE_PASS(MachineOutliner, DEBUG_TYPE,
-                "Machine Function Outliner", false, false)
+INITIALIZE_PASS_BEGIN(MachineOutliner, DEBUG_TYPE,
+                      "Machine Function Outliner", false, false)
+INITIALIZE_PASS_DEPENDENCY(ProfileSummaryInfoWrapperPass)
+INITIALIZE_PASS_END(MachineOutliner, DEBUG_TYPE,
+                    "Machine Function Outliner", false, false)
 
 void MachineOutliner::pruneOverlaps(std::vector<Candidate> &CandidateList,
                                     std::vector<OutlinedFunction> &FunctionList,
@@ -1211,6 +1226,8 @@ bool MachineOutliner::runOnModule(Module &M) {
                                       .getSubtarget();
   const TargetRegisterInfo *TRI = STI.getRegisterInfo();
   const TargetInstrInfo *TII = STI.getInstrInfo();
+  ProfileSummaryInfo *PSI =
+      getAnalysis<ProfileSummaryInfoWrapperPass>().getPSI();
 
   InstructionMapper Mapper;
 
@@ -1222,6 +1239,12 @@ bool MachineOutliner::runOnModule(Module &M) {
     if (F.empty() || !TII->isFunctionSafeToOutlineFrom(MF))
       continue;
 
+    // Don't slow down hot code by adding calls to it.
+    if (!OutlineFromHotFunctions && PSI->isFunctionEntryHot(&F)) {
+      ++NumHotFunctionsSkipped;
+      continue;
+    }
+
     // If it is, look at each MachineBasicBlock in the function.
     for (MachineBasicBlock &MBB : MF) {
 
@@ -21,16 +21,23 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/Utils/SplitModule.h"
 
 using namespace llvm;
 
+typedef std::function<void(LLVMContext &, legacy::PassManagerBase &)>
+    PartitionSetupTy;
+
 static void codegen(Module *M, llvm::raw_pwrite_stream &OS,
                     function_ref<std::unique_ptr<TargetMachine>()> TMFactory,
-                    TargetMachine::CodeGenFileType FileType) {
+                    TargetMachine::CodeGenFileType FileType,
+                    const PartitionSetupTy &PartitionSetup) {
   std::unique_ptr<TargetMachine> TM = TMFactory();
   legacy::PassManager CodeGenPasses;
+  if (PartitionSetup)
+    PartitionSetup(M->getContext(), CodeGenPasses);
   if (TM->addPassesToEmitFile(CodeGenPasses, OS, FileType))
     report_fatal_error("Failed to setup codegen");
   CodeGenPasses.run(*M);
@@ -40,13 +47,14 @@ std::unique_ptr<Module> llvm::splitCodeGen(
     std::unique_ptr<Module> M, ArrayRef<llvm::raw_pwrite_stream *> OSs,
     ArrayRef<llvm::raw_pwrite_stream *> BCOSs,
     const std::function<std::unique_ptr<TargetMachine>()> &TMFactory,
-    TargetMachine::CodeGenFileType FileType, bool PreserveLocals) {
+    TargetMachine::CodeGenFileType FileType, bool PreserveLocals,
+    const PartitionSetupTy &PartitionSetup) {
   assert(BCOSs.empty() || BCOSs.size() == OSs.size());
 
   if (OSs.size() == 1) {
     if (!BCOSs.empty())
       WriteBitcodeToFile(M.get(), *BCOSs[0]);
-    codegen(M.get(), *OSs[0], TMFactory, FileType);
+    codegen(M.get(), *OSs[0], TMFactory, FileType, PartitionSetup);
     return M;
   }
 
@@ -55,6 +63,12 @@ std::unique_ptr<Module> llvm::splitCodeGen(
   {
     ThreadPool CodegenThreadPool(OSs.size());
     int ThreadCount = 0;
+    // The time trace profiler of the calling thread does not see the other
+    // threads: profile each of them, with the same granularity, and hand the
+    // result over when it is done.
+    bool TimeTrace = timeTraceProfilerEnabled();
+    unsigned TimeTraceGranularity =
+        TimeTrace ? timeTraceProfilerGranularity() : 0;
 
     SplitModule(
         std::move(M), OSs.size(),
@@ -77,7 +91,10 @@ std::unique_ptr<Module> llvm::splitCodeGen(
           llvm::raw_pwrite_stream *ThreadOS = OSs[ThreadCount++];
           // Enqueue the task
           CodegenThreadPool.async(
-              [TMFactory, FileType, ThreadOS](const SmallString<0> &BC) {
+              [TMFactory, FileType, ThreadOS, PartitionSetup, TimeTrace,
+               TimeTraceGranularity](const SmallString<0> &BC) {
+                if (TimeTrace)
+                  timeTraceProfilerInitialize(TimeTraceGranularity);
                 LLVMContext Ctx;
                 Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
                     MemoryBufferRef(StringRef(BC.data(), BC.size()),
@@ -87,7 +104,10 @@ std::unique_ptr<Module> llvm::splitCodeGen(
                   report_fatal_error("Failed to read bitcode");
                 std::unique_ptr<Module> MPartInCtx = std::move(MOrErr.get());
 
-                codegen(MPartInCtx.get(), *ThreadOS, TMFactory, FileType);
+                codegen(MPartInCtx.get(), *ThreadOS, TMFactory, FileType,
+                        PartitionSetup);
+                if (TimeTrace)
+                  timeTraceProfilerFinishThread();
               },
               // Pass BC using std::move to ensure that it get moved rather than
               // copied into the thread's context.
@@ -84,6 +84,8 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumGrowRegionOverBudget,
+          "Number of region splits given up because growRegion hit its budget");
 
 static cl::opt<SplitEditor::ComplementSpillMode> SplitSpillMode(
     "split-spill-mode", cl::Hidden,
@@ -129,6 +131,20 @@ CSRFirstTimeCost("regalloc-csr-first-time-cost",
               cl::desc("Cost for first time use of callee-saved register."),
               cl::init(0), cl::Hidden);
 
+static cl::opt<unsigned> GrowRegionComplexityBudget(
+    "grow-region-complexity-budget",
+    cl::desc("growRegion() does not scale with the number of edge bundle "
+             "blocks, so limit the blocks it looks at for one candidate "
+             "and bail out once the limit is reached"),
+    cl::init(10000), cl::Hidden);
+
+static cl::opt<unsigned> GrowRegionFunctionBudget(
+    "grow-region-function-budget",
+    cl::desc("Limit the blocks growRegion() looks at for all the region "
+             "split candidates of a function; once it is spent, live ranges "
+             "are split around blocks instead (0 = unlimited)"),
+    cl::init(50000000), cl::Hidden);
+
 static RegisterRegAlloc greedyRegAlloc("greedy", "greedy register allocator",
                                        createGreedyRegisterAllocator);
 
@@ -166,6 +182,10 @@ class RAGreedy : public MachineFunctionPass,
   PQueue Queue;
   unsigned NextCascade;
 
+  /// Blocks growRegion() may still look at in this function, see
+  /// -grow-region-function-budget.
+  uint64_t GrowRegionFunctionBudgetLeft;
+
   // Live ranges pass through a number of stages as we try to allocate them.
   // Some of the stages may also create new live ranges:
   //
@@ -381,7 +401,7 @@ private:
   BlockFrequency calcSpillCost();
   bool addSplitConstraints(InterferenceCache::Cursor, BlockFrequency&);
   void addThroughConstraints(InterferenceCache::Cursor, ArrayRef<unsigned>);
-  void growRegion(GlobalSplitCandidate &Cand);
+  bool growRegion(GlobalSplitCandidate &Cand);
   BlockFrequency calcGlobalSplitCost(GlobalSplitCandidate&);
   bool calcCompactRegion(GlobalSplitCandidate&);
   void splitAroundRegion(LiveRangeEdit&, ArrayRef<unsigned>);
@@ -1099,11 +1119,16 @@ void RAGreedy::addThroughConstraints(InterferenceCache::Cursor Intf,
   SpillPlacer->addLinks(makeArrayRef(TBS, T));
 }
 
-void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
+/// growRegion - Grow the region of Cand through the live-through blocks that
+/// the spill placer wants live. Returns false if the blocks looked at would
+/// exceed the budget of the candidate or of the function, in which case Cand
+/// must be discarded.
+bool RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
   // Keep track of through blocks that have not been added to SpillPlacer.
   BitVector Todo = SA->getThroughBlocks();
   SmallVectorImpl<unsigned> &ActiveBlocks = Cand.ActiveBlocks;
   unsigned AddedTo = 0;
+  uint64_t Budget = GrowRegionComplexityBudget;
 #ifndef NDEBUG
   unsigned Visited = 0;
 #endif
@@ -1115,6 +1140,15 @@ void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
       unsigned Bundle = NewBundles[i];
       // Look at all blocks connected to Bundle in the full graph.
       ArrayRef<unsigned> Blocks = Bundles->getBlocks(Bundle);
+      // Limit compile time by bailing out once a budget is used up.
+      if (Blocks.size() >= Budget ||
+          Blocks.size() >= GrowRegionFunctionBudgetLeft) {
+        ++NumGrowRegionOverBudget;
+        DEBUG(dbgs() << ", over budget");
+        return false;
+      }
+      Budget -= Blocks.size();
+      GrowRegionFunctionBudgetLeft -= Blocks.size();
       for (ArrayRef<unsigned>::iterator I = Blocks.begin(), E = Blocks.end();
            I != E; ++I) {
         unsigned Block = *I;
@@ -1147,6 +1181,7 @@ void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
     SpillPlacer->iterate();
   }
   DEBUG(dbgs() << ", v=" << Visited);
+  return true;
 }
 
 /// calcCompactRegion - Compute the set of edge bundles that should be live
@@ -1177,7 +1212,10 @@ bool RAGreedy::calcCompactRegion(GlobalSplitCandidate &Cand) {
     return false;
   }
 
-  growRegion(Cand);
+  if (!growRegion(Cand)) {
+    DEBUG(dbgs() << ", none.\n");
+    return false;
+  }
   SpillPlacer->finish();
 
   if (!Cand.LiveBundles.any()) {
@@ -1491,7 +1529,10 @@ unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
       });
       continue;
     }
-    growRegion(Cand);
+    if (!growRegion(Cand)) {
+      DEBUG(dbgs() << '\n');
+      continue;
+    }
 
     SpillPlacer->finish();
 
@@ -2757,6 +2798,9 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   ExtraRegInfo.clear();
   ExtraRegInfo.resize(MRI->getNumVirtRegs());
   NextCascade = 1;
+  GrowRegionFunctionBudgetLeft = GrowRegionFunctionBudget
+                                     ? uint64_t(GrowRegionFunctionBudget)
+                                     : UINT64_MAX;
   IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
   GlobalCand.resize(32);  // This will grow as needed.
   SetOfBrokenHints.clear();
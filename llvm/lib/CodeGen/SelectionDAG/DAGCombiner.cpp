@@ -21,6 +21,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineFunction.h"
@@ -34,8 +35,12 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/KnownBits.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetLowering.h"
 #include "llvm/Target/TargetOptions.h"
@@ -52,6 +57,9 @@ STATISTIC(PostIndexedNodes, "Number of post-indexed nodes created");
 STATISTIC(OpsNarrowed     , "Number of load/op/store narrowed");
 STATISTIC(LdStFP2Int      , "Number of fp load/store pairs transformed to int");
 STATISTIC(SlicedLoads, "Number of load sliced");
+STATISTIC(NodesVisited, "Number of dag nodes visited by the combiner");
+STATISTIC(NodesDeferred,
+          "Number of dag nodes deferred until their operands are combined");
 
 namespace {
   static cl::opt<bool>
@@ -81,6 +89,43 @@ namespace {
     MaySplitLoadIndex("combiner-split-load-index", cl::Hidden, cl::init(true),
                       cl::desc("DAG combiner may split indexing from loads"));
 
+  static cl::opt<bool>
+    TopologicalWorklist("combiner-topological-worklist", cl::Hidden,
+                        cl::init(false),
+                        cl::desc("Combine the operands of a node before the "
+                                 "node itself"));
+
+  static cl::opt<bool>
+    CombinerOpcodeStats("combiner-opcode-stats", cl::Hidden,
+                        cl::desc("Print the number of nodes visited and "
+                                 "combined, and the time spent combining them, "
+                                 "for each opcode"));
+
+  /// Visit and combine counts, and the time spent in combine(), for nodes
+  /// of one opcode.
+  struct OpcodeCombineStats {
+    std::string Name;
+    unsigned Visited = 0;
+    unsigned Combined = 0;
+    TimeRecord Time;
+
+    void add(const OpcodeCombineStats &RHS) {
+      Visited += RHS.Visited;
+      Combined += RHS.Combined;
+      Time += RHS.Time;
+    }
+  };
+
+  /// The -combiner-opcode-stats of all combiner runs in the process, keyed
+  /// by opcode name since target opcodes differ between targets. They are
+  /// printed, sorted by time, when the process shuts down.
+  struct CombineStatsTable {
+    sys::SmartMutex<true> Lock;
+    StringMap<OpcodeCombineStats> Stats;
+
+    ~CombineStatsTable();
+  };
+
 //------------------------------ DAGCombiner ---------------------------------//
 
   class DAGCombiner {
@@ -114,6 +159,15 @@ namespace {
     /// which have not yet been combined to the worklist.
     SmallPtrSet<SDNode *, 32> CombinedNodes;
 
+    /// \brief Set of nodes which have been put back on the worklist until
+    /// their operands are combined, with -combiner-topological-worklist.
+    ///
+    /// A node is deferred at most once, which guarantees progress.
+    SmallPtrSet<SDNode *, 32> DeferredNodes;
+
+    /// Per-opcode statistics of this run, with -combiner-opcode-stats.
+    DenseMap<unsigned, OpcodeCombineStats> OpcodeStats;
+
     // AA - Used for DAG load/store alias analysis.
     AliasAnalysis *AA;
 
@@ -146,6 +200,7 @@ namespace {
     /// Remove all instances of N from the worklist.
     void removeFromWorklist(SDNode *N) {
       CombinedNodes.erase(N);
+      DeferredNodes.erase(N);
 
       auto It = WorklistMap.find(N);
       if (It == WorklistMap.end())
@@ -156,6 +211,21 @@ namespace {
       WorklistMap.erase(It);
     }
 
+    /// Add N to the worklist, or move it to the back if it is already on it,
+    /// so that it is the next node processed.
+    void moveToBackOfWorklist(SDNode *N) {
+      auto It = WorklistMap.find(N);
+      if (It != WorklistMap.end()) {
+        Worklist[It->second] = nullptr;
+        WorklistMap.erase(It);
+      }
+      AddToWorklist(N);
+    }
+
+    /// If N has operands that have not been combined yet, put N back on the
+    /// worklist behind them and return true.
+    bool deferUntilOperandsCombined(SDNode *N);
+
     void deleteAndRecombine(SDNode *N);
     bool recursivelyDeleteUnusedNodes(SDNode *N);
 
@@ -559,6 +629,8 @@ public:
 };
 }
 
+static ManagedStatic<CombineStatsTable> CombineStats;
+
 //===----------------------------------------------------------------------===//
 //  TargetLowering::DAGCombinerInfo implementation
 //===----------------------------------------------------------------------===//
@@ -1339,6 +1411,9 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
     if (recursivelyDeleteUnusedNodes(N))
       continue;
 
+    if (TopologicalWorklist && deferUntilOperandsCombined(N))
+      continue;
+
     WorklistRemover DeadNodes(*this);
 
     // If this combine is running after legalizing the DAG, re-legalize any
@@ -1365,12 +1440,27 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
       if (!CombinedNodes.count(ChildN.getNode()))
         AddToWorklist(ChildN.getNode());
 
+    ++NodesVisited;
+    OpcodeCombineStats *Stats = nullptr;
+    if (CombinerOpcodeStats) {
+      Stats = &OpcodeStats[N->getOpcode()];
+      if (Stats->Name.empty())
+        Stats->Name = N->getOperationName(&DAG);
+      ++Stats->Visited;
+      Stats->Time -= TimeRecord::getCurrentTime(/*Start=*/true);
+    }
+
     SDValue RV = combine(N);
 
+    if (Stats)
+      Stats->Time += TimeRecord::getCurrentTime(/*Start=*/false);
+
     if (!RV.getNode())
       continue;
 
     ++NodesCombined;
+    if (Stats)
+      ++Stats->Combined;
 
     // If we get back the same node we passed in, rather than a new node or
     // zero, we know that the node must have defined multiple values and
@@ -1408,6 +1498,64 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
   // If the root changed (e.g. it was a dead load, update the root).
   DAG.setRoot(Dummy.getValue());
   DAG.RemoveDeadNodes();
+
+  if (!OpcodeStats.empty()) {
+    sys::SmartScopedLock<true> Lock(CombineStats->Lock);
+    for (auto &Entry : OpcodeStats) {
+      OpcodeCombineStats &Total = CombineStats->Stats[Entry.second.Name];
+      if (Total.Name.empty())
+        Total.Name = Entry.second.Name;
+      Total.add(Entry.second);
+    }
+    OpcodeStats.clear();
+  }
+}
+
+bool DAGCombiner::deferUntilOperandsCombined(SDNode *N) {
+  if (!DeferredNodes.insert(N).second)
+    return false;
+
+  // Put N back first, so that the operands pushed after it are popped before.
+  bool Deferred = false;
+  for (const SDValue &ChildN : N->op_values()) {
+    SDNode *Child = ChildN.getNode();
+    if (CombinedNodes.count(Child) || Child->getOpcode() == ISD::HANDLENODE)
+      continue;
+    if (!Deferred) {
+      AddToWorklist(N);
+      Deferred = true;
+    }
+    moveToBackOfWorklist(Child);
+  }
+
+  if (Deferred)
+    ++NodesDeferred;
+  return Deferred;
+}
+
+CombineStatsTable::~CombineStatsTable() {
+  if (Stats.empty())
+    return;
+
+  std::vector<const OpcodeCombineStats *> Sorted;
+  for (const auto &Entry : Stats)
+    Sorted.push_back(&Entry.second);
+  std::sort(Sorted.begin(), Sorted.end(),
+            [](const OpcodeCombineStats *A, const OpcodeCombineStats *B) {
+              return A->Time.getWallTime() > B->Time.getWallTime();
+            });
+
+  std::unique_ptr<raw_fd_ostream> OS = CreateInfoOutputFile();
+  *OS << "===" << std::string(73, '-') << "===\n"
+      << "                      DAG combiner statistics per opcode\n"
+      << "===" << std::string(73, '-') << "===\n\n"
+      << "  Wall Time    Visited   Combined  Opcode\n";
+  for (const OpcodeCombineStats *S : Sorted)
+    *OS << format("%11.4f %10u %10u  ", S->Time.getWallTime(), S->Visited,
+                  S->Combined)
+        << S->Name << '\n';
+  *OS << '\n';
+  OS->flush();
 }
 
 SDValue DAGCombiner::visit(SDNode *N) {
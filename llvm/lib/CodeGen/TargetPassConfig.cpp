@@ -599,8 +599,10 @@ bool TargetPassConfig::addCoreISelPasses() {
 
   // Ask the target for an isel.
   // Enable GlobalISel if the target wants to, but allow that to be overriden.
+  // Explicitly enabling fast-isel overrides implicitly enabled global-isel.
   if (EnableGlobalISel == cl::BOU_TRUE ||
-      (EnableGlobalISel == cl::BOU_UNSET && isGlobalISelEnabled())) {
+      (EnableGlobalISel == cl::BOU_UNSET && isGlobalISelEnabled() &&
+       EnableFastISelOption != cl::BOU_TRUE)) {
     if (addIRTranslator())
       return true;
 
@@ -1024,6 +1026,11 @@ bool TargetPassConfig::isGlobalISelEnabled() const {
 }
 
 bool TargetPassConfig::isGlobalISelAbortEnabled() const {
+  // When the target enables GlobalISel by default, fall back to SDISel on
+  // unsupported input unless -global-isel-abort asks otherwise.
+  if (EnableGlobalISel == cl::BOU_UNSET && isGlobalISelEnabled() &&
+      EnableGlobalISelAbort.getNumOccurrences() == 0)
+    return false;
   return EnableGlobalISelAbort == 1;
 }
 
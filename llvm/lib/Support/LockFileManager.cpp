@@ -15,9 +15,11 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cerrno>
+#include <chrono>
 #include <ctime>
 #include <memory>
 #include <sys/stat.h>
@@ -41,6 +43,17 @@
 #include <uuid/uuid.h>
 #endif
 
+#if defined(__linux__)
+#define USE_INOTIFY 1
+#else
+#define USE_INOTIFY 0
+#endif
+
+#if USE_INOTIFY
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
 using namespace llvm;
 
 /// \brief Attempt to read the lock file with the given name, if it exists.
@@ -293,10 +306,75 @@ LockFileManager::~LockFileManager() {
   sys::DontRemoveFileOnSignal(UniqueLockFileName);
 }
 
+#if USE_INOTIFY
+/// \brief Wait for up to \p Milliseconds for the file \p FileName to be
+/// removed from the directory watched by the inotify instance \p WatchFD.
+static void waitForRemoval(int WatchFD, StringRef FileName, long Milliseconds) {
+  auto Deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(Milliseconds);
+  while (true) {
+    auto Remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        Deadline - std::chrono::steady_clock::now());
+    if (Remaining.count() <= 0)
+      return;
+
+    struct pollfd PollFD;
+    PollFD.fd = WatchFD;
+    PollFD.events = POLLIN;
+    PollFD.revents = 0;
+    int Ready = poll(&PollFD, 1, Remaining.count());
+    if (Ready < 0 && errno == EINTR)
+      continue;
+    if (Ready <= 0)
+      return;
+
+    // Other files in the directory come and go too; only return early for
+    // the removal of the one we wait for.
+    alignas(struct inotify_event) char Buffer[4096];
+    ssize_t Length = read(WatchFD, Buffer, sizeof(Buffer));
+    if (Length < 0 && errno != EAGAIN && errno != EINTR)
+      return;
+    for (ssize_t Offset = 0; Offset < Length;) {
+      const struct inotify_event *Event =
+          reinterpret_cast<const struct inotify_event *>(Buffer + Offset);
+      if (Event->len && FileName == Event->name)
+        return;
+      Offset += sizeof(struct inotify_event) + Event->len;
+    }
+  }
+}
+#endif
+
 LockFileManager::WaitForUnlockResult LockFileManager::waitForUnlock() {
   if (getState() != LFS_Shared)
     return Res_Success;
 
+#if USE_INOTIFY
+  // Watch the directory of the lock file, so that we wake up as soon as the
+  // owner removes it rather than at the end of the interval. Fall back to
+  // sleeping if inotify is not available.
+  int WatchFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (WatchFD >= 0) {
+    SmallString<128> LockFileDir(LockFileName);
+    sys::path::remove_filename(LockFileDir);
+    if (LockFileDir.empty())
+      LockFileDir = ".";
+    if (inotify_add_watch(WatchFD, LockFileDir.c_str(),
+                          IN_DELETE | IN_MOVED_FROM) < 0) {
+      close(WatchFD);
+      WatchFD = -1;
+    }
+  }
+  StringRef LockFileBaseName = sys::path::filename(LockFileName);
+  struct WatchCloser {
+    int FD;
+    ~WatchCloser() {
+      if (FD >= 0)
+        close(FD);
+    }
+  } CloseWatch = {WatchFD};
+#endif
+
 #if LLVM_ON_WIN32
   unsigned long Interval = 1;
 #else
@@ -310,10 +388,14 @@ LockFileManager::WaitForUnlockResult LockFileManager::waitForUnlock() {
   do {
     // Sleep for the designated interval, to allow the owning process time to
     // finish up and remove the lock file.
-    // FIXME: Should we hook in to system APIs to get a notification when the
-    // lock file is deleted?
 #if LLVM_ON_WIN32
     Sleep(Interval);
+#elif USE_INOTIFY
+    if (WatchFD >= 0)
+      waitForRemoval(WatchFD, LockFileBaseName,
+                     Interval.tv_sec * 1000 + Interval.tv_nsec / 1000000);
+    else
+      nanosleep(&Interval, nullptr);
 #else
     nanosleep(&Interval, nullptr);
 #endif
@@ -0,0 +1,255 @@
+//===-- TimeProfiler.cpp - Hierarchical Time Profiler ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the hierarchical time profiler.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace llvm {
+
+LLVM_THREAD_LOCAL TimeTraceProfiler *TimeTraceProfilerInstance = nullptr;
+
+typedef duration<steady_clock::rep, steady_clock::period> DurationType;
+typedef std::pair<size_t, DurationType> CountAndDurationType;
+typedef std::pair<std::string, CountAndDurationType>
+    NameAndCountAndDurationType;
+
+struct TimeTraceProfilerEntry {
+  time_point<steady_clock> Start;
+  DurationType Duration;
+  std::string Name;
+  std::string Detail;
+
+  TimeTraceProfilerEntry(time_point<steady_clock> Start, std::string Name,
+                         std::string Detail)
+      : Start(Start), Duration(0), Name(std::move(Name)),
+        Detail(std::move(Detail)) {}
+};
+
+namespace {
+
+/// Writes \p S as the contents of a JSON string.
+void writeEscaped(raw_ostream &OS, StringRef S) {
+  for (unsigned char C : S) {
+    switch (C) {
+    case '"':
+      OS << "\\\"";
+      break;
+    case '\\':
+      OS << "\\\\";
+      break;
+    case '\n':
+      OS << "\\n";
+      break;
+    case '\t':
+      OS << "\\t";
+      break;
+    default:
+      if (C < 0x20)
+        OS << format("\\u%04x", C);
+      else
+        OS << C;
+      break;
+    }
+  }
+}
+
+} // end anonymous namespace
+
+struct TimeTraceProfiler {
+  TimeTraceProfiler(unsigned TimeTraceGranularity)
+      : StartTime(steady_clock::now()),
+        TimeTraceGranularity(TimeTraceGranularity) {}
+
+  void begin(std::string Name, function_ref<std::string()> Detail) {
+    Stack.emplace_back(steady_clock::now(), std::move(Name), Detail());
+  }
+
+  void end() {
+    assert(!Stack.empty() && "Must call begin() first");
+    TimeTraceProfilerEntry &E = Stack.back();
+    E.Duration = steady_clock::now() - E.Start;
+
+    // Only include sections longer than the granularity into the trace, so
+    // that the trace stays small even when it covers many short sections.
+    if (duration_cast<microseconds>(E.Duration).count() >=
+        TimeTraceGranularity)
+      Entries.emplace_back(E);
+
+    // Track the total time spent in each kind of section. Recursive sections
+    // of the same kind are only counted once, by the outermost one.
+    auto SameName = [&](const TimeTraceProfilerEntry &Val) {
+      return Val.Name == E.Name;
+    };
+    if (std::find_if(Stack.rbegin() + 1, Stack.rend(), SameName) ==
+        Stack.rend()) {
+      auto &CountAndTotal = CountAndTotalPerName[E.Name];
+      CountAndTotal.first++;
+      CountAndTotal.second += E.Duration;
+    }
+
+    Stack.pop_back();
+  }
+
+  /// Writes the sections of this profiler and of the profilers of the
+  /// \p Threads that finished, each on its own row, followed by their totals.
+  void write(raw_ostream &OS, ArrayRef<TimeTraceProfiler *> Threads) {
+    OS << "{\"traceEvents\":[";
+    bool First = true;
+    auto BeginEvent = [&](unsigned Tid) {
+      if (!First)
+        OS << ",";
+      First = false;
+      OS << "\n{\"pid\":1,\"tid\":" << Tid << ",";
+    };
+
+    // Emit the sections, relative to the start of this profiler, which is the
+    // first one.
+    auto WriteEntries = [&](const TimeTraceProfiler &P, unsigned Tid) {
+      for (const TimeTraceProfilerEntry &E : P.Entries) {
+        auto StartUs = duration_cast<microseconds>(E.Start - StartTime).count();
+        auto DurUs = duration_cast<microseconds>(E.Duration).count();
+        BeginEvent(Tid);
+        OS << "\"ph\":\"X\",\"ts\":" << StartUs << ",\"dur\":" << DurUs
+           << ",\"name\":\"";
+        writeEscaped(OS, E.Name);
+        OS << "\",\"args\":{\"detail\":\"";
+        writeEscaped(OS, E.Detail);
+        OS << "\"}}";
+      }
+    };
+    unsigned Tid = 0;
+    WriteEntries(*this, Tid++);
+    for (const TimeTraceProfiler *P : Threads)
+      WriteEntries(*P, Tid++);
+
+    // Emit the totals of all the threads, sorted by decreasing duration, each
+    // on its own row since they do not nest. The sections of different
+    // threads overlap, so a total may exceed the wall time.
+    StringMap<CountAndDurationType> AllCountAndTotalPerName;
+    auto AddTotals = [&](const TimeTraceProfiler &P) {
+      for (const auto &Total : P.CountAndTotalPerName) {
+        auto &CountAndTotal = AllCountAndTotalPerName[Total.getKey()];
+        CountAndTotal.first += Total.getValue().first;
+        CountAndTotal.second += Total.getValue().second;
+      }
+    };
+    AddTotals(*this);
+    for (const TimeTraceProfiler *P : Threads)
+      AddTotals(*P);
+
+    std::vector<NameAndCountAndDurationType> SortedTotals;
+    for (const auto &Total : AllCountAndTotalPerName)
+      SortedTotals.emplace_back(Total.getKey().str(), Total.getValue());
+    std::sort(SortedTotals.begin(), SortedTotals.end(),
+              [](const NameAndCountAndDurationType &A,
+                 const NameAndCountAndDurationType &B) {
+                return A.second.second > B.second.second;
+              });
+    for (const auto &Total : SortedTotals) {
+      auto DurUs = duration_cast<microseconds>(Total.second.second).count();
+      auto Count = Total.second.first;
+      BeginEvent(Tid++);
+      OS << "\"ph\":\"X\",\"ts\":0,\"dur\":" << DurUs
+         << ",\"name\":\"Total ";
+      writeEscaped(OS, Total.first);
+      OS << "\",\"args\":{\"count\":" << Count
+         << ",\"avg ms\":" << (DurUs / Count / 1000) << "}}";
+    }
+
+    OS << "\n]}\n";
+  }
+
+  SmallVector<TimeTraceProfilerEntry, 16> Stack;
+  std::vector<TimeTraceProfilerEntry> Entries;
+  StringMap<CountAndDurationType> CountAndTotalPerName;
+  time_point<steady_clock> StartTime;
+
+  /// The minimum duration of the sections that are written, in microseconds.
+  unsigned TimeTraceGranularity;
+};
+
+/// The profilers handed over by the threads that finished.
+static ManagedStatic<sys::SmartMutex<true>> FinishedThreadsLock;
+static ManagedStatic<std::vector<TimeTraceProfiler *>> FinishedThreads;
+
+void timeTraceProfilerInitialize(unsigned TimeTraceGranularity) {
+  assert(TimeTraceProfilerInstance == nullptr &&
+         "Profiler should not be initialized");
+  TimeTraceProfilerInstance = new TimeTraceProfiler(TimeTraceGranularity);
+}
+
+unsigned timeTraceProfilerGranularity() {
+  assert(TimeTraceProfilerInstance != nullptr &&
+         "Profiler object can't be null");
+  return TimeTraceProfilerInstance->TimeTraceGranularity;
+}
+
+void timeTraceProfilerFinishThread() {
+  if (TimeTraceProfilerInstance == nullptr)
+    return;
+  sys::SmartScopedLock<true> Lock(*FinishedThreadsLock);
+  FinishedThreads->push_back(TimeTraceProfilerInstance);
+  TimeTraceProfilerInstance = nullptr;
+}
+
+void timeTraceProfilerCleanup() {
+  delete TimeTraceProfilerInstance;
+  TimeTraceProfilerInstance = nullptr;
+  sys::SmartScopedLock<true> Lock(*FinishedThreadsLock);
+  for (TimeTraceProfiler *P : *FinishedThreads)
+    delete P;
+  FinishedThreads->clear();
+}
+
+void timeTraceProfilerWrite(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance != nullptr &&
+         "Profiler object can't be null");
+  sys::SmartScopedLock<true> Lock(*FinishedThreadsLock);
+  TimeTraceProfilerInstance->write(OS, *FinishedThreads);
+}
+
+void timeTraceProfilerBegin(StringRef Name, StringRef Detail) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->begin(Name.str(),
+                                     [&]() { return Detail.str(); });
+}
+
+void timeTraceProfilerBegin(StringRef Name, const char *Detail) {
+  timeTraceProfilerBegin(Name, StringRef(Detail));
+}
+
+void timeTraceProfilerBegin(StringRef Name,
+                            function_ref<std::string()> Detail) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->begin(Name.str(), Detail);
+}
+
+void timeTraceProfilerEnd() {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->end();
+}
+
+} // end namespace llvm
@@ -10550,7 +10550,15 @@ unsigned X86InstrInfo::getOutliningBenefit(size_t SequenceSize,
 }
 
 bool X86InstrInfo::isFunctionSafeToOutlineFrom(MachineFunction &MF) const {
-  return MF.getFunction()->hasFnAttribute(Attribute::NoRedZone);
+  // The outlined calls and returns are 64-bit only.
+  if (!Subtarget.is64Bit())
+    return false;
+
+  // A call to an outlined function pushes the return address, which would
+  // clobber anything the function keeps in the red zone. The frame lowering
+  // has already decided whether the red zone is used.
+  return MF.getFunction()->hasFnAttribute(Attribute::NoRedZone) ||
+         !MF.getInfo<X86MachineFunctionInfo>()->getUsesRedZone();
 }
 
 X86GenInstrInfo::MachineOutlinerInstrType
@@ -54,6 +54,12 @@ static cl::opt<bool> EnableMachineCombinerPass("x86-machine-combiner",
                                cl::desc("Enable the machine combiner pass"),
                                cl::init(true), cl::Hidden);
 
+static cl::opt<int> EnableGlobalISelAtO(
+    "x86-enable-global-isel-at-O", cl::Hidden,
+    cl::desc("Enable GlobalISel for x86-64 at or below an opt level (-1 to "
+             "disable)"),
+    cl::init(-1));
+
 namespace llvm {
 
 void initializeWinEHStatePassPass(PassRegistry &);
@@ -299,6 +305,7 @@ public:
   bool addLegalizeMachineIR() override;
   bool addRegBankSelect() override;
   bool addGlobalInstructionSelect() override;
+  bool isGlobalISelEnabled() const override;
 #endif
   bool addILPOpts() override;
   bool addPreISel() override;
@@ -369,6 +376,12 @@ bool X86PassConfig::addGlobalInstructionSelect() {
   addPass(new InstructionSelect());
   return false;
 }
+
+bool X86PassConfig::isGlobalISelEnabled() const {
+  // The legalizer and the register banks only handle 64-bit mode for now.
+  return TM->getTargetTriple().getArch() == Triple::x86_64 &&
+         TM->getOptLevel() <= EnableGlobalISelAtO;
+}
 #endif
 
 bool X86PassConfig::addILPOpts() {
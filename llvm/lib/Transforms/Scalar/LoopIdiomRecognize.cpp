@@ -70,6 +70,7 @@ using namespace llvm;
 
 STATISTIC(NumMemSet, "Number of memset's formed from loop stores");
 STATISTIC(NumMemCpy, "Number of memcpy's formed from loop load+stores");
+STATISTIC(NumMemChr, "Number of memchr's formed from loop byte searches");
 
 static cl::opt<bool> UseLIRCodeSizeHeurs(
     "use-lir-code-size-heurs",
@@ -157,6 +158,7 @@ private:
   void transformLoopToCountable(BasicBlock *PreCondBB, Instruction *CntInst,
                                 PHINode *CntPhi, Value *Var, const DebugLoc DL,
                                 bool ZeroCheck, bool IsCntPhiUsedOutsideLoop);
+  bool recognizeMemChr();
 
   /// @}
 };
@@ -242,7 +244,7 @@ bool LoopIdiomRecognize::runOnLoop(Loop *L) {
 
   // Disable loop idiom recognition if the function's name is a common idiom.
   StringRef Name = L->getHeader()->getParent()->getName();
-  if (Name == "memset" || Name == "memcpy")
+  if (Name == "memset" || Name == "memcpy" || Name == "memchr")
     return false;
 
   // Determine if code size heuristics need to be applied.
@@ -1052,7 +1054,7 @@ bool LoopIdiomRecognize::avoidLIRForMultiBlockLoop(bool IsMemset,
 }
 
 bool LoopIdiomRecognize::runOnNoncountableLoop() {
-  return recognizePopcount() || recognizeAndInsertCTLZ();
+  return recognizePopcount() || recognizeAndInsertCTLZ() || recognizeMemChr();
 }
 
 /// Check if the given conditional branch is based on the comparison between
@@ -1683,3 +1685,165 @@ void LoopIdiomRecognize::transformLoopToPopcount(BasicBlock *PreCondBB,
   //   loop. The loop would otherwise not be deleted even if it becomes empty.
   SE->forgetLoop(CurLoop);
 }
+
+/// Recognizes a loop that searches a byte buffer for the first occurrence of
+/// a value, as std::find and hand-written memchr loops do:
+///
+/// loop:
+///   %p = phi i8* [ %begin, %preheader ], [ %p.next, %latch ]
+///   %c = load i8, i8* %p
+///   %found = icmp eq i8 %c, %x
+///   br i1 %found, label %exit, label %latch
+/// latch:
+///   %p.next = getelementptr i8, i8* %p, i64 1
+///   %done = icmp eq i8* %p.next, %end
+///   br i1 %done, label %exit, label %loop
+///
+/// The search is replaced by a call to memchr in the preheader, whose library
+/// implementation compares many bytes at a time, and the values live out of
+/// the loop are recomputed from its result. The loop itself is left without
+/// any users for LoopDeletion to remove.
+bool LoopIdiomRecognize::recognizeMemChr() {
+  if (!TLI->has(LibFunc_memchr))
+    return false;
+
+  // The loop should consist of a header that tests the loaded byte and a
+  // latch that tests for the end of the buffer, both exiting to one block.
+  BasicBlock *Preheader = CurLoop->getLoopPreheader();
+  BasicBlock *Header = CurLoop->getHeader();
+  BasicBlock *Latch = CurLoop->getLoopLatch();
+  BasicBlock *ExitBB = CurLoop->getUniqueExitBlock();
+  if (CurLoop->getNumBlocks() != 2 || !Latch || Latch == Header || !ExitBB)
+    return false;
+
+  auto *HeaderBI = dyn_cast<BranchInst>(Header->getTerminator());
+  auto *LatchBI = dyn_cast<BranchInst>(Latch->getTerminator());
+  if (!HeaderBI || !HeaderBI->isConditional() || !LatchBI ||
+      !LatchBI->isConditional())
+    return false;
+  if (LatchBI->getSuccessor(0) != Header && LatchBI->getSuccessor(1) != Header)
+    return false;
+
+  auto *Cond = dyn_cast<ICmpInst>(HeaderBI->getCondition());
+  if (!Cond || !Cond->isEquality())
+    return false;
+  BasicBlock *FoundBB = HeaderBI->getSuccessor(
+      Cond->getPredicate() == ICmpInst::ICMP_EQ ? 0 : 1);
+  if (FoundBB != ExitBB)
+    return false;
+
+  auto *Load = dyn_cast<LoadInst>(Cond->getOperand(0));
+  Value *Byte = Cond->getOperand(1);
+  if (!Load) {
+    Load = dyn_cast<LoadInst>(Cond->getOperand(1));
+    Byte = Cond->getOperand(0);
+  }
+  if (!Load || !Load->isSimple() || !Load->getType()->isIntegerTy(8) ||
+      Load->getPointerAddressSpace() != 0 || !CurLoop->contains(Load) ||
+      !CurLoop->isLoopInvariant(Byte))
+    return false;
+
+  // Nothing in the loop may have an effect that the call would not have.
+  for (BasicBlock *BB : CurLoop->blocks())
+    for (Instruction &I : *BB)
+      if (I.mayHaveSideEffects())
+        return false;
+
+  // The loop should load successive bytes, and the latch should exit after a
+  // computable number of them.
+  auto *Ev = dyn_cast<SCEVAddRecExpr>(SE->getSCEV(Load->getPointerOperand()));
+  if (!Ev || Ev->getLoop() != CurLoop || !Ev->isAffine())
+    return false;
+  auto *Stride = dyn_cast<SCEVConstant>(Ev->getStepRecurrence(*SE));
+  if (!Stride || !Stride->getValue()->isOne())
+    return false;
+
+  // A latch that compares pointers has a count of pointer type, which is
+  // used as an integer of the same width, as for memset and memcpy.
+  Type *IntPtrTy = DL->getIntPtrType(Header->getContext());
+  const SCEV *LatchCount = SE->getExitCount(CurLoop, Latch);
+  if (isa<SCEVCouldNotCompute>(LatchCount) ||
+      SE->getTypeSizeInBits(LatchCount->getType()) >
+          DL->getTypeSizeInBits(IntPtrTy))
+    return false;
+  LatchCount = SE->getNoopOrZeroExtend(LatchCount, IntPtrTy);
+
+  // Short searches of a known length are better left to the unroller.
+  if (auto *ConstCount = dyn_cast<SCEVConstant>(LatchCount))
+    if (ConstCount->getAPInt().ult(16))
+      return false;
+
+  if (!isSafeToExpand(Ev->getStart(), *SE) || !isSafeToExpand(LatchCount, *SE))
+    return false;
+
+  // Every value live out of the loop must be invariant, or an induction
+  // variable that can be evaluated at the iteration the loop exits in.
+  auto IsComputableExitValue = [&](Value *V) {
+    if (CurLoop->isLoopInvariant(V))
+      return true;
+    if (!SE->isSCEVable(V->getType()))
+      return false;
+    auto *AR = dyn_cast<SCEVAddRecExpr>(SE->getSCEV(V));
+    return AR && AR->getLoop() == CurLoop && AR->isAffine() &&
+           isSafeToExpand(AR->getStart(), *SE) &&
+           isSafeToExpand(AR->getStepRecurrence(*SE), *SE);
+  };
+  SmallVector<PHINode *, 4> ExitPHIs;
+  for (PHINode &PN : ExitBB->phis()) {
+    if (!IsComputableExitValue(PN.getIncomingValueForBlock(Header)) ||
+        !IsComputableExitValue(PN.getIncomingValueForBlock(Latch)))
+      return false;
+    ExitPHIs.push_back(&PN);
+  }
+
+  DEBUG(dbgs() << "  " << Header->getParent()->getName()
+               << " : LIR Memchr from loop " << Header->getName() << "\n");
+
+  Instruction *InsertPt = Preheader->getTerminator();
+  SCEVExpander Expander(*SE, *DL, "memchr");
+  Value *Begin = Expander.expandCodeFor(Ev->getStart(),
+                                        Load->getPointerOperandType(),
+                                        InsertPt);
+  Value *Len = Expander.expandCodeFor(
+      SE->getAddExpr(LatchCount, SE->getOne(IntPtrTy)), IntPtrTy, InsertPt);
+
+  IRBuilder<> Builder(InsertPt);
+  Builder.SetCurrentDebugLocation(Cond->getDebugLoc());
+  Value *Found =
+      emitMemChr(Begin, Builder.CreateZExt(Byte, Builder.getInt32Ty()), Len,
+                 Builder, *DL, TLI);
+  Value *NotFound = Builder.CreateIsNull(Found, "memchr.notfound");
+  Value *FoundIdx =
+      Builder.CreateSub(Builder.CreatePtrToInt(Found, IntPtrTy),
+                        Builder.CreatePtrToInt(Begin, IntPtrTy), "memchr.idx");
+  const SCEV *FoundCount = SE->getSCEV(FoundIdx);
+
+  // Evaluates the exit value \p V, leaving the loop after \p Count backedges.
+  auto ExpandExitValue = [&](Value *V, const SCEV *Count) -> Value * {
+    if (CurLoop->isLoopInvariant(V))
+      return V;
+    auto *AR = cast<SCEVAddRecExpr>(SE->getSCEV(V));
+    const SCEV *Step = AR->getStepRecurrence(*SE);
+    const SCEV *S = SE->getAddExpr(
+        AR->getStart(),
+        SE->getMulExpr(SE->getTruncateOrZeroExtend(Count, Step->getType()),
+                       Step));
+    return Expander.expandCodeFor(S, V->getType(), InsertPt);
+  };
+  for (PHINode *PN : ExitPHIs) {
+    Value *FoundVal =
+        ExpandExitValue(PN->getIncomingValueForBlock(Header), FoundCount);
+    Value *NotFoundVal =
+        ExpandExitValue(PN->getIncomingValueForBlock(Latch), LatchCount);
+    Value *Sel = Builder.CreateSelect(NotFound, NotFoundVal, FoundVal,
+                                      PN->getName() + ".memchr");
+    SE->forgetValue(PN);
+    // The exit block may also be reached from outside the loop, for example
+    // from a guard that skips the search; those incoming values stay.
+    PN->setIncomingValue(PN->getBasicBlockIndex(Header), Sel);
+    PN->setIncomingValue(PN->getBasicBlockIndex(Latch), Sel);
+  }
+
+  ++NumMemChr;
+  return true;
+}
@@ -41,6 +41,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/GraphWriter.h"
 #include "llvm/Support/KnownBits.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/LoopUtils.h"
 #include "llvm/Transforms/Vectorize.h"
@@ -54,6 +55,10 @@ using namespace slpvectorizer;
 #define DEBUG_TYPE "SLP"
 
 STATISTIC(NumVectorInstructions, "Number of vector instructions generated");
+STATISTIC(NumTreesBuilt, "Number of vectorizable trees built");
+STATISTIC(NumTreeNodes, "Number of vectorizable tree nodes visited");
+STATISTIC(NumBlocksOverBudget,
+          "Number of blocks that exhausted the SLP tree budget");
 
 static cl::opt<int>
     SLPCostThreshold("slp-threshold", cl::init(0), cl::Hidden,
@@ -81,6 +86,14 @@ static cl::opt<int>
 ScheduleRegionSizeBudget("slp-schedule-budget", cl::init(100000), cl::Hidden,
     cl::desc("Limit the size of the SLP scheduling region per block"));
 
+/// Limits the number of tree nodes built per block, over all the attempts to
+/// vectorize it. Once exhausted, the remaining seeds of the block are only
+/// gathered. This keeps compile time in check for huge unrolled blocks.
+static cl::opt<unsigned>
+BlockTreeBudget("slp-block-budget", cl::init(100000), cl::Hidden,
+    cl::desc("Limit the number of SLP tree nodes built per block "
+             "(0 = unlimited)"));
+
 static cl::opt<int> MinVectorRegSizeOption(
     "slp-min-reg-size", cl::init(128), cl::Hidden,
     cl::desc("Attempt to vectorize for this register size in bits"));
@@ -307,7 +320,8 @@ public:
           TargetLibraryInfo *TLi, AliasAnalysis *Aa, LoopInfo *Li,
           DominatorTree *Dt, AssumptionCache *AC, DemandedBits *DB,
           const DataLayout *DL, OptimizationRemarkEmitter *ORE)
-      : NumLoadsWantToKeepOrder(0), NumLoadsWantToChangeOrder(0), F(Func),
+      : NumLoadsWantToKeepOrder(0), NumLoadsWantToChangeOrder(0),
+        TreeBudgetLeft(BlockTreeBudget), F(Func),
         SE(Se), TTI(Tti), TLI(TLi), AA(Aa), LI(Li), DT(Dt), AC(AC), DB(DB),
         DL(DL), ORE(ORE), Builder(Se->getContext()) {
     CodeMetrics::collectEphemeralValues(F, AC, EphValues);
@@ -373,6 +387,15 @@ public:
 
   unsigned getTreeSize() const { return VectorizableTree.size(); }
 
+  /// Resets the tree budget before vectorizing a new block.
+  void resetTreeBudget() { TreeBudgetLeft = BlockTreeBudget; }
+
+  /// \returns true if the current block has used up its tree budget, after
+  /// which buildTree only gathers the roots.
+  bool isTreeBudgetExhausted() const {
+    return BlockTreeBudget && TreeBudgetLeft == 0;
+  }
+
   /// \brief Perform LICM and CSE on the newly generated gather sequences.
   void optimizeGatherSequence();
 
@@ -945,6 +968,9 @@ private:
   // Number of load bundles that contain consecutive loads in reversed order.
   int NumLoadsWantToChangeOrder;
 
+  // Number of tree nodes that may still be built in the current block.
+  unsigned TreeBudgetLeft;
+
   // Analysis and block reference.
   Function *F;
   ScalarEvolution *SE;
@@ -1057,10 +1083,15 @@ void BoUpSLP::buildTree(ArrayRef<Value *> Roots,
 void BoUpSLP::buildTree(ArrayRef<Value *> Roots,
                         ExtraValueToDebugLocsMap &ExternallyUsedValues,
                         ArrayRef<Value *> UserIgnoreLst) {
+  TimeTraceScope TimeScope("SLPBuildTree", [&]() {
+    auto *I = dyn_cast<Instruction>(Roots[0]);
+    return I ? I->getParent()->getName().str() : std::string();
+  });
   deleteTree();
   UserIgnoreList = UserIgnoreLst;
   if (!allSameType(Roots))
     return;
+  ++NumTreesBuilt;
   buildTree_rec(Roots, 0, -1);
 
   // Collect the values that we need to extract from the tree.
@@ -1128,6 +1159,15 @@ void BoUpSLP::buildTree_rec(ArrayRef<Value *> VL, unsigned Depth,
     return;
   }
 
+  if (isTreeBudgetExhausted()) {
+    DEBUG(dbgs() << "SLP: Gathering due to exhausted block budget.\n");
+    newTreeEntry(VL, false, UserTreeIdx);
+    return;
+  }
+  ++NumTreeNodes;
+  if (BlockTreeBudget && --TreeBudgetLeft == 0)
+    ++NumBlocksOverBudget;
+
   // Don't handle vectors.
   if (VL[0]->getType()->isVectorTy()) {
     DEBUG(dbgs() << "SLP: Gathering due to vector type.\n");
@@ -3870,6 +3910,8 @@ bool SLPVectorizerPass::runImpl(Function &F, ScalarEvolution *SE_,
 
   // Scan the blocks in the function in post order.
   for (auto BB : post_order(&F.getEntryBlock())) {
+    TimeTraceScope TimeScope("SLPVectorizeBlock", BB->getName());
+    R.resetTreeBudget();
     collectSeedInstructions(BB);
 
     // Vectorize trees that end at stores.
@@ -3879,6 +3921,13 @@ bool SLPVectorizerPass::runImpl(Function &F, ScalarEvolution *SE_,
       Changed |= vectorizeStoreChains(R);
     }
 
+    // The rest of the block would only be gathered.
+    if (R.isTreeBudgetExhausted()) {
+      DEBUG(dbgs() << "SLP: Tree budget exhausted in " << BB->getName()
+                   << ".\n");
+      continue;
+    }
+
     // Vectorize trees that end at reductions.
     Changed |= vectorizeChainsInBlock(BB, R);
 
@@ -5133,6 +5182,8 @@ bool SLPVectorizerPass::vectorizeStoreChains(BoUpSLP &R) {
     //       For example, AVX2 supports v32i8. Increasing this limit, however,
     //       may cause a significant compile-time increase.
     for (unsigned CI = 0, CE = it->second.size(); CI < CE; CI+=16) {
+      if (R.isTreeBudgetExhausted())
+        return Changed;
       unsigned Len = std::min<unsigned>(CE - CI, 16);
       Changed |= vectorizeStores(makeArrayRef(&it->second[CI], Len), R);
     }
@@ -23,6 +23,7 @@
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/SourceMgr.h"
 #include "gtest/gtest.h"
 
@@ -930,5 +931,62 @@ TEST_F(ScalarEvolutionsTest, SCEVZeroExtendExprNonIntegral) {
   EXPECT_FALSE(verifyFunction(*F, &errs()));
 }
 
+// Once the work budget of the function is exhausted, SCEV gives conservative
+// answers for the values and loops it has not analyzed yet, but keeps the
+// results it computed before.
+TEST_F(ScalarEvolutionsTest, SCEVWorkBudget) {
+  LLVMContext C;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(
+      "define void @f(i32 %n) { "
+      "entry: "
+      "  %a = add i32 %n, 1 "
+      "  br label %loop "
+      "loop: "
+      "  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ] "
+      "  %i.next = add nuw nsw i32 %i, 1 "
+      "  %cond = icmp eq i32 %i.next, 16 "
+      "  br i1 %cond, label %exit, label %loop "
+      "exit: "
+      "  ret void "
+      "} ",
+      Err, C);
+  ASSERT_TRUE(M && "Could not parse module?");
+
+  auto *MaxWork = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions()["scalar-evolution-max-work"]);
+  ASSERT_TRUE(MaxWork);
+  unsigned SavedMaxWork = *MaxWork;
+
+  runWithSE(*M, "f", [&](Function &F, LoopInfo &LI, ScalarEvolution &SE) {
+    const Loop *L = LI.getLoopFor(getInstructionByName(F, "i")->getParent());
+    EXPECT_TRUE(isa<SCEVAddRecExpr>(
+        SE.getSCEV(getInstructionByName(F, "i.next"))));
+    const SCEV *Count = SE.getBackedgeTakenCount(L);
+    ASSERT_TRUE(isa<SCEVConstant>(Count));
+    EXPECT_EQ(cast<SCEVConstant>(Count)->getAPInt(), 15u);
+  });
+
+  // Analyzing %a takes a single unit of work, which is the whole budget.
+  *MaxWork = 1;
+  runWithSE(*M, "f", [&](Function &F, LoopInfo &LI, ScalarEvolution &SE) {
+    Instruction *A = getInstructionByName(F, "a");
+    const SCEV *SA = SE.getSCEV(A);
+    EXPECT_TRUE(isa<SCEVAddExpr>(SA));
+
+    Instruction *INext = getInstructionByName(F, "i.next");
+    const SCEV *SINext = SE.getSCEV(INext);
+    ASSERT_TRUE(isa<SCEVUnknown>(SINext));
+    EXPECT_EQ(cast<SCEVUnknown>(SINext)->getValue(), INext);
+
+    const Loop *L = LI.getLoopFor(INext->getParent());
+    EXPECT_TRUE(isa<SCEVCouldNotCompute>(SE.getBackedgeTakenCount(L)));
+    EXPECT_TRUE(isa<SCEVCouldNotCompute>(SE.getMaxBackedgeTakenCount(L)));
+
+    EXPECT_EQ(SE.getSCEV(A), SA);
+  });
+  *MaxWork = SavedMaxWork;
+}
+
 }  // end anonymous namespace
 }  // end namespace llvm
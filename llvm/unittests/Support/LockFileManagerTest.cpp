@@ -8,10 +8,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/LockFileManager.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
+#include <chrono>
 #include <memory>
+#include <thread>
 
 using namespace llvm;
 
@@ -124,4 +129,39 @@ TEST(LockFileManagerTest, RelativePath) {
   ASSERT_FALSE(EC);
 }
 
+#if LLVM_ENABLE_THREADS
+TEST(LockFileManagerTest, WaitForUnlock) {
+  SmallString<64> TmpDir;
+  std::error_code EC;
+  EC = sys::fs::createUniqueDirectory("LockFileManagerTestDir", TmpDir);
+  ASSERT_FALSE(EC);
+
+  SmallString<64> LockedFile(TmpDir);
+  sys::path::append(LockedFile, "file");
+
+  auto Owner = llvm::make_unique<LockFileManager>(LockedFile);
+  ASSERT_EQ(LockFileManager::LFS_Owned, Owner->getState());
+  LockFileManager Waiter(LockedFile);
+  ASSERT_EQ(LockFileManager::LFS_Shared, Waiter.getState());
+
+  // Create the file and release the lock while the waiter is waiting.
+  std::thread OwnerThread([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+      std::error_code EC;
+      raw_fd_ostream Out(LockedFile, EC, sys::fs::F_None);
+      EXPECT_FALSE(EC);
+    }
+    Owner.reset();
+  });
+  EXPECT_EQ(LockFileManager::Res_Success, Waiter.waitForUnlock());
+  OwnerThread.join();
+
+  EC = sys::fs::remove(StringRef(LockedFile));
+  ASSERT_FALSE(EC);
+  EC = sys::fs::remove(StringRef(TmpDir));
+  ASSERT_FALSE(EC);
+}
+#endif
+
 } // end anonymous namespace
@@ -0,0 +1,95 @@
+//===- unittests/TimeProfilerTest.cpp - Time profiler tests ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <thread>
+
+using namespace llvm;
+
+namespace {
+
+TEST(TimeProfiler, DisabledScopes) {
+  EXPECT_FALSE(timeTraceProfilerEnabled());
+  bool DetailComputed = false;
+  {
+    TimeTraceScope Scope("Disabled", [&]() {
+      DetailComputed = true;
+      return std::string("detail");
+    });
+  }
+  EXPECT_FALSE(DetailComputed);
+}
+
+TEST(TimeProfiler, WritesNestedSections) {
+  timeTraceProfilerInitialize();
+  EXPECT_TRUE(timeTraceProfilerEnabled());
+  {
+    TimeTraceScope Outer("Outer", "a\"b");
+    {
+      TimeTraceScope Inner("Inner", [] { return std::string("c\nd"); });
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+
+  std::string Trace;
+  raw_string_ostream OS(Trace);
+  timeTraceProfilerWrite(OS);
+  OS.flush();
+  timeTraceProfilerCleanup();
+  EXPECT_FALSE(timeTraceProfilerEnabled());
+
+  EXPECT_EQ(0u, Trace.find("{\"traceEvents\":["));
+  EXPECT_NE(std::string::npos,
+            Trace.find("\"name\":\"Outer\",\"args\":{\"detail\":\"a\\\"b\"}"));
+  EXPECT_NE(std::string::npos,
+            Trace.find("\"name\":\"Inner\",\"args\":{\"detail\":\"c\\nd\"}"));
+  EXPECT_NE(std::string::npos, Trace.find("\"name\":\"Total Outer\""));
+  EXPECT_NE(std::string::npos, Trace.find("\"name\":\"Total Inner\""));
+}
+
+TEST(TimeProfiler, WritesFinishedThreads) {
+  timeTraceProfilerInitialize();
+  {
+    TimeTraceScope Scope("Main");
+    std::thread Worker([] {
+      EXPECT_FALSE(timeTraceProfilerEnabled());
+      timeTraceProfilerInitialize();
+      {
+        TimeTraceScope Scope("Worker", "w");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+      timeTraceProfilerFinishThread();
+      EXPECT_FALSE(timeTraceProfilerEnabled());
+    });
+    Worker.join();
+  }
+
+  std::string Trace;
+  raw_string_ostream OS(Trace);
+  timeTraceProfilerWrite(OS);
+  OS.flush();
+  timeTraceProfilerCleanup();
+
+  // The sections of the worker are written on their own row.
+  size_t Main = Trace.find("\"name\":\"Main\"");
+  size_t Worker = Trace.find("\"name\":\"Worker\",\"args\":{\"detail\":\"w\"}");
+  ASSERT_NE(std::string::npos, Main);
+  ASSERT_NE(std::string::npos, Worker);
+  EXPECT_EQ(Trace.rfind("\n{\"pid\":1,\"tid\":0,", Main),
+            Trace.rfind('\n', Main));
+  EXPECT_EQ(Trace.rfind("\n{\"pid\":1,\"tid\":1,", Worker),
+            Trace.rfind('\n', Worker));
+  EXPECT_NE(std::string::npos, Trace.find("\"name\":\"Total Main\""));
+  EXPECT_NE(std::string::npos, Trace.find("\"name\":\"Total Worker\""));
+}
+
+} // end anon namespace
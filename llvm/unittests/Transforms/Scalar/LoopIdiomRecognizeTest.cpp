@@ -0,0 +1,225 @@
+//===- LoopIdiomRecognizeTest.cpp - LoopIdiomRecognize unit tests ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Transforms/Scalar.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+const char *Prologue =
+    "target datalayout = \"e-m:e-i64:64-n8:16:32:64-S128\"\n"
+    "target triple = \"x86_64-unknown-linux-gnu\"\n";
+
+std::unique_ptr<Module> parseIR(LLVMContext &C, StringRef IR) {
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M =
+      parseAssemblyString((Twine(Prologue) + IR).str(), Err, C);
+  if (!M)
+    Err.print("LoopIdiomRecognizeTest", errs());
+  return M;
+}
+
+void runLIR(Module &M) {
+  legacy::PassManager PM;
+  PM.add(createLoopIdiomPass());
+  PM.run(M);
+}
+
+CallInst *findMemChr(Function &F) {
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB)
+      if (auto *CI = dyn_cast<CallInst>(&I))
+        if (CI->getCalledFunction() &&
+            CI->getCalledFunction()->getName() == "memchr")
+          return CI;
+  return nullptr;
+}
+
+Value *getValueByName(Function &F, StringRef Name) {
+  for (Argument &A : F.args())
+    if (A.getName() == Name)
+      return &A;
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB)
+      if (I.getName() == Name)
+        return &I;
+  return nullptr;
+}
+
+// A search through the bytes [%begin, %begin + %n), returning the index of
+// the first byte equal to %x, or %n. \p Count replaces %n in the exit test,
+// \p Load is the load instruction and \p Latch is added to the latch.
+std::string getIndexSearch(StringRef Count = "%n", StringRef Load = "load",
+                           StringRef Latch = "") {
+  return (Twine("define i64 @f(i8* %begin, i64 %n, i8 %x, i8* %q) {\n"
+                "entry:\n"
+                "  br label %loop\n"
+                "loop:\n"
+                "  %i = phi i64 [ 0, %entry ], [ %i.next, %latch ]\n"
+                "  %p = getelementptr inbounds i8, i8* %begin, i64 %i\n"
+                "  %c = ") +
+          Load + " i8, i8* %p\n"
+                 "  %found = icmp eq i8 %c, %x\n"
+                 "  br i1 %found, label %exit, label %latch\n"
+                 "latch:\n" +
+          Latch + "  %i.next = add nuw i64 %i, 1\n"
+                  "  %done = icmp eq i64 %i.next, " +
+          Count + "\n"
+                  "  br i1 %done, label %exit, label %loop\n"
+                  "exit:\n"
+                  "  %r = phi i64 [ %i, %loop ], [ %i.next, %latch ]\n"
+                  "  ret i64 %r\n"
+                  "}\n")
+      .str();
+}
+
+TEST(LoopIdiomRecognizeTest, MemChr) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseIR(C, getIndexSearch());
+  ASSERT_TRUE(M);
+  Function &F = *M->getFunction("f");
+  runLIR(*M);
+  EXPECT_FALSE(verifyFunction(F, &errs()));
+
+  // memchr(%begin, zext(%x), count + 1) in the preheader, where the latch
+  // exits after count = %n - 1 backedges.
+  CallInst *Call = findMemChr(F);
+  ASSERT_TRUE(Call);
+  EXPECT_EQ(Call->getParent(), &F.getEntryBlock());
+  EXPECT_EQ(Call->getArgOperand(0), getValueByName(F, "begin"));
+  auto *Byte = dyn_cast<ZExtInst>(Call->getArgOperand(1));
+  ASSERT_TRUE(Byte);
+  EXPECT_EQ(Byte->getOperand(0), getValueByName(F, "x"));
+  EXPECT_TRUE(Byte->getType()->isIntegerTy(32));
+  EXPECT_EQ(Call->getArgOperand(2), getValueByName(F, "n"));
+
+  // %r is the index of the byte found, or %n, on both exits.
+  auto *R = cast<PHINode>(getValueByName(F, "r"));
+  auto *Sel = dyn_cast<SelectInst>(R->getIncomingValue(0));
+  ASSERT_TRUE(Sel);
+  EXPECT_EQ(R->getIncomingValue(1), Sel);
+  auto *NotFound = dyn_cast<ICmpInst>(Sel->getCondition());
+  ASSERT_TRUE(NotFound);
+  EXPECT_EQ(NotFound->getOperand(0), Call);
+  EXPECT_TRUE(isa<ConstantPointerNull>(NotFound->getOperand(1)));
+  EXPECT_EQ(Sel->getTrueValue(), getValueByName(F, "n"));
+  EXPECT_EQ(Sel->getFalseValue(), getValueByName(F, "memchr.idx"));
+}
+
+// The exit values of pointer and narrower integer induction variables, whose
+// value on the exit from the header differs from the one from the latch.
+TEST(LoopIdiomRecognizeTest, MemChrExitValues) {
+  LLVMContext C;
+  std::unique_ptr<Module> M =
+      parseIR(C, "define void @f(i8* %begin, i8* %end, i8 %x, i8** %rp, "
+                 "i32* %kp) {\n"
+                 "entry:\n"
+                 "  br label %loop\n"
+                 "loop:\n"
+                 "  %p = phi i8* [ %begin, %entry ], [ %p.next, %latch ]\n"
+                 "  %k = phi i32 [ 0, %entry ], [ %k.next, %latch ]\n"
+                 "  %c = load i8, i8* %p\n"
+                 "  %found = icmp eq i8 %x, %c\n"
+                 "  br i1 %found, label %exit, label %latch\n"
+                 "latch:\n"
+                 "  %p.next = getelementptr inbounds i8, i8* %p, i64 1\n"
+                 "  %k.next = add i32 %k, 1\n"
+                 "  %done = icmp eq i8* %p.next, %end\n"
+                 "  br i1 %done, label %exit, label %loop\n"
+                 "exit:\n"
+                 "  %r = phi i8* [ %p, %loop ], [ %p.next, %latch ]\n"
+                 "  %s = phi i32 [ %k, %loop ], [ %k.next, %latch ]\n"
+                 "  store i8* %r, i8** %rp\n"
+                 "  store i32 %s, i32* %kp\n"
+                 "  ret void\n"
+                 "}\n");
+  ASSERT_TRUE(M);
+  Function &F = *M->getFunction("f");
+  runLIR(*M);
+  EXPECT_FALSE(verifyFunction(F, &errs()));
+  CallInst *Call = findMemChr(F);
+  ASSERT_TRUE(Call);
+  Value *Idx = getValueByName(F, "memchr.idx");
+  ASSERT_TRUE(Idx);
+
+  // %r is the byte found, or %end.
+  auto *R = cast<PHINode>(getValueByName(F, "r"));
+  auto *RSel = dyn_cast<SelectInst>(R->getIncomingValue(0));
+  ASSERT_TRUE(RSel);
+  EXPECT_EQ(R->getIncomingValue(1), RSel);
+  EXPECT_EQ(RSel->getTrueValue(), getValueByName(F, "end"));
+  auto *Found = dyn_cast<GetElementPtrInst>(RSel->getFalseValue());
+  ASSERT_TRUE(Found);
+  EXPECT_EQ(Found->getPointerOperand(), getValueByName(F, "begin"));
+  EXPECT_EQ(Found->getOperand(1), Idx);
+
+  // %s is the index of the byte found, or the number of bytes searched,
+  // truncated to i32.
+  auto *S = cast<PHINode>(getValueByName(F, "s"));
+  auto *SSel = dyn_cast<SelectInst>(S->getIncomingValue(0));
+  ASSERT_TRUE(SSel);
+  EXPECT_EQ(S->getIncomingValue(1), SSel);
+  EXPECT_EQ(SSel->getCondition(), RSel->getCondition());
+  auto *FoundIdx = dyn_cast<TruncInst>(SSel->getFalseValue());
+  ASSERT_TRUE(FoundIdx);
+  EXPECT_EQ(FoundIdx->getOperand(0), Idx);
+  EXPECT_TRUE(FoundIdx->getType()->isIntegerTy(32));
+  auto *Len = dyn_cast<BinaryOperator>(SSel->getTrueValue());
+  ASSERT_TRUE(Len);
+  EXPECT_EQ(Len->getOpcode(), Instruction::Add);
+  EXPECT_TRUE(isa<TruncInst>(Len->getOperand(0)));
+  EXPECT_EQ(Len->getOperand(1), ConstantInt::get(Len->getType(), 1));
+}
+
+TEST(LoopIdiomRecognizeTest, MemChrShortConstantLength) {
+  LLVMContext C;
+
+  // Searches of fewer than 16 bytes are left to the unroller.
+  std::unique_ptr<Module> M = parseIR(C, getIndexSearch("16"));
+  ASSERT_TRUE(M);
+  runLIR(*M);
+  EXPECT_FALSE(findMemChr(*M->getFunction("f")));
+
+  M = parseIR(C, getIndexSearch("17"));
+  ASSERT_TRUE(M);
+  runLIR(*M);
+  CallInst *Call = findMemChr(*M->getFunction("f"));
+  ASSERT_TRUE(Call);
+  auto *Len = dyn_cast<ConstantInt>(Call->getArgOperand(2));
+  ASSERT_TRUE(Len);
+  EXPECT_EQ(Len->getZExtValue(), 17u);
+}
+
+TEST(LoopIdiomRecognizeTest, MemChrSideEffects) {
+  LLVMContext C;
+
+  std::unique_ptr<Module> M =
+      parseIR(C, getIndexSearch("%n", "load", "  store i8 0, i8* %q\n"));
+  ASSERT_TRUE(M);
+  runLIR(*M);
+  EXPECT_FALSE(findMemChr(*M->getFunction("f")));
+
+  M = parseIR(C, getIndexSearch("%n", "load volatile"));
+  ASSERT_TRUE(M);
+  runLIR(*M);
+  EXPECT_FALSE(findMemChr(*M->getFunction("f")));
+}
+
+}  // end anonymous namespace